@@ -0,0 +1,297 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_TESTS_OTHER_STAND_IN_STRATEGIES_HPP
+#define NFD_TESTS_OTHER_STAND_IN_STRATEGIES_HPP
+
+#include <map>
+#include <random>
+
+#include "fw/strategy.hpp"
+
+namespace nfd {
+namespace sim {
+
+/** \brief simplified stand-ins for NFD's built-in strategies
+ *
+ *  These reproduce the forwarding decisions that matter for a scorecard
+ *  (which faces an Interest goes to, and when it is retried) without the
+ *  details of any particular NFD release, so the comparison does not
+ *  depend on which built-in strategies the NFD tree provides.
+ */
+
+static inline bool
+canForwardTo(const shared_ptr<pit::Entry>& pitEntry, const Face& inFace, const Face& face)
+{
+  return inFace.getId() != face.getId() && pitEntry->canForwardTo(face);
+}
+
+/** \brief forwards to the lowest-cost eligible nexthop, retransmissions
+ *         go to the next unused nexthop
+ */
+class BestRouteStandIn : public fw::Strategy
+{
+public:
+  explicit
+  BestRouteStandIn(Forwarder& forwarder)
+    : Strategy(forwarder, STRATEGY_NAME)
+  {
+  }
+
+  virtual void
+  afterReceiveInterest(const Face& inFace, const Interest& interest,
+                       shared_ptr<fib::Entry> fibEntry,
+                       shared_ptr<pit::Entry> pitEntry) DECL_OVERRIDE
+  {
+    const bool isRetransmission = pitEntry->hasUnexpiredOutRecords();
+
+    for (const auto& nexthop : fibEntry->getNextHops())
+      {
+        const shared_ptr<Face>& face = nexthop.getFace();
+        if (!canForwardTo(pitEntry, inFace, *face))
+          continue;
+
+        if (isRetransmission && pitEntry->getOutRecord(face) != pitEntry->getOutRecords().end())
+          continue;
+
+        this->sendInterest(pitEntry, face);
+        return;
+      }
+
+    if (!isRetransmission)
+      this->rejectPendingInterest(pitEntry);
+  }
+
+public:
+  static const Name STRATEGY_NAME;
+};
+
+const Name BestRouteStandIn::STRATEGY_NAME("ndn:/localhost/nfd/strategy/stand-in/best-route");
+
+/** \brief forwards every new Interest to all eligible nexthops
+ */
+class MulticastStandIn : public fw::Strategy
+{
+public:
+  explicit
+  MulticastStandIn(Forwarder& forwarder)
+    : Strategy(forwarder, STRATEGY_NAME)
+  {
+  }
+
+  virtual void
+  afterReceiveInterest(const Face& inFace, const Interest& interest,
+                       shared_ptr<fib::Entry> fibEntry,
+                       shared_ptr<pit::Entry> pitEntry) DECL_OVERRIDE
+  {
+    if (pitEntry->hasUnexpiredOutRecords())
+      return;
+
+    bool isSent = false;
+    for (const auto& nexthop : fibEntry->getNextHops())
+      {
+        if (canForwardTo(pitEntry, inFace, *nexthop.getFace()))
+          {
+            this->sendInterest(pitEntry, nexthop.getFace());
+            isSent = true;
+          }
+      }
+
+    if (!isSent)
+      this->rejectPendingInterest(pitEntry);
+  }
+
+public:
+  static const Name STRATEGY_NAME;
+};
+
+const Name MulticastStandIn::STRATEGY_NAME("ndn:/localhost/nfd/strategy/stand-in/multicast");
+
+/** \brief adaptive SRTT-based forwarding in the manner of ASF
+ *
+ *  Uses the eligible face with the lowest smoothed RTT.  A face with
+ *  consecutive timeouts is ranked last, and once per probing interval a
+ *  copy of the Interest probes another face so rankings can change.
+ */
+class AsfStandIn : public fw::Strategy
+{
+public:
+  explicit
+  AsfStandIn(Forwarder& forwarder)
+    : Strategy(forwarder, STRATEGY_NAME)
+    , m_random(0)
+  {
+  }
+
+  virtual void
+  afterReceiveInterest(const Face& inFace, const Interest& interest,
+                       shared_ptr<fib::Entry> fibEntry,
+                       shared_ptr<pit::Entry> pitEntry) DECL_OVERRIDE
+  {
+    if (pitEntry->hasUnexpiredOutRecords())
+      return;
+
+    auto info = getOrCreateInfo(*fibEntry);
+
+    std::vector<shared_ptr<Face>> eligible;
+    shared_ptr<Face> best;
+    for (const auto& nexthop : fibEntry->getNextHops())
+      {
+        const shared_ptr<Face>& face = nexthop.getFace();
+        if (!canForwardTo(pitEntry, inFace, *face))
+          continue;
+
+        eligible.push_back(face);
+        if (best == nullptr || info->isBetter(face->getId(), best->getId()))
+          best = face;
+      }
+
+    if (best == nullptr)
+      {
+        this->rejectPendingInterest(pitEntry);
+        return;
+      }
+
+    pitEntry->setStrategyInfo(make_shared<PitInfo>());
+    this->sendInterest(pitEntry, best);
+
+    const auto now = time::steady_clock::now();
+    if (eligible.size() > 1 && now >= info->nextProbe)
+      {
+        info->nextProbe = now + PROBING_INTERVAL;
+
+        std::uniform_int_distribution<size_t> dist(0, eligible.size() - 2);
+        size_t index = dist(m_random);
+        if (eligible[index] == best)
+          index = eligible.size() - 1;
+        this->sendInterest(pitEntry, eligible[index]);
+      }
+  }
+
+  virtual void
+  beforeSatisfyInterest(shared_ptr<pit::Entry> pitEntry, const Face& inFace,
+                        const Data& data) DECL_OVERRIDE
+  {
+    auto pitInfo = pitEntry->getStrategyInfo<PitInfo>();
+    auto measurementsEntry = this->getMeasurements().get(*pitEntry);
+    if (pitInfo == nullptr || measurementsEntry == nullptr)
+      return;
+
+    auto info = measurementsEntry->getStrategyInfo<MeasurementInfo>();
+    if (info == nullptr)
+      return;
+
+    auto& face = info->faces[inFace.getId()];
+    const double rtt =
+      time::duration_cast<time::microseconds>(time::steady_clock::now() -
+                                              pitInfo->sendTime).count() / 1000.0;
+    face.srtt = face.srtt == 0 ? rtt : face.srtt + (rtt - face.srtt) / 8;
+    face.nTimeouts = 0;
+  }
+
+  virtual void
+  beforeExpirePendingInterest(shared_ptr<pit::Entry> pitEntry) DECL_OVERRIDE
+  {
+    auto measurementsEntry = this->getMeasurements().get(*pitEntry);
+    if (measurementsEntry == nullptr)
+      return;
+
+    auto info = measurementsEntry->getStrategyInfo<MeasurementInfo>();
+    if (info == nullptr)
+      return;
+
+    for (const auto& outRecord : pitEntry->getOutRecords())
+      ++info->faces[outRecord.getFace()->getId()].nTimeouts;
+  }
+
+public:
+  static const Name STRATEGY_NAME;
+
+private:
+  class PitInfo : public StrategyInfo
+  {
+  public:
+    static constexpr int
+    getTypeId() { return 9990; }
+
+    time::steady_clock::TimePoint sendTime = time::steady_clock::now();
+  };
+
+  class MeasurementInfo : public StrategyInfo
+  {
+  public:
+    static constexpr int
+    getTypeId() { return 9991; }
+
+    struct FaceStats
+    {
+      double srtt = 0;
+      int nTimeouts = 0;
+    };
+
+    /// unmeasured faces rank first so they get measured, timed out faces last
+    bool
+    isBetter(FaceId a, FaceId b)
+    {
+      const FaceStats& x = faces[a];
+      const FaceStats& y = faces[b];
+      if ((x.nTimeouts >= MAX_TIMEOUTS) != (y.nTimeouts >= MAX_TIMEOUTS))
+        return y.nTimeouts >= MAX_TIMEOUTS;
+      return x.srtt < y.srtt;
+    }
+
+    std::map<FaceId, FaceStats> faces;
+    time::steady_clock::TimePoint nextProbe;
+  };
+
+  shared_ptr<MeasurementInfo>
+  getOrCreateInfo(const fib::Entry& fibEntry)
+  {
+    auto measurementsEntry = this->getMeasurements().get(fibEntry);
+    this->getMeasurements().extendLifetime(*measurementsEntry, time::seconds(16));
+
+    auto info = measurementsEntry->getStrategyInfo<MeasurementInfo>();
+    if (info == nullptr)
+      {
+        info = make_shared<MeasurementInfo>();
+        measurementsEntry->setStrategyInfo(info);
+      }
+    return info;
+  }
+
+private:
+  static const int MAX_TIMEOUTS = 3;
+  static const time::milliseconds PROBING_INTERVAL;
+
+  std::mt19937 m_random;
+};
+
+const Name AsfStandIn::STRATEGY_NAME("ndn:/localhost/nfd/strategy/stand-in/asf");
+const time::milliseconds AsfStandIn::PROBING_INTERVAL(1000);
+
+} // namespace sim
+} // namespace nfd
+
+#endif // NFD_TESTS_OTHER_STAND_IN_STRATEGIES_HPP
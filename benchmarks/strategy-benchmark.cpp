@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  Microbenchmark of one Interest/Data exchange through each strategy.
+ *
+ *  Every operation is an Interest received from the consumer, forwarded by
+ *  the strategy under test and answered immediately by one of four
+ *  upstreams.  The forwarding pipeline is part of each operation, so the
+ *  best-route row is reported as the reference cost of the pipeline.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+#include "strategy-simulator.hpp"
+
+#include "fw/weighted-load-balancer-strategy.hpp"
+#include "fw/random-load-balancer-strategy.hpp"
+#include "fw/best-route-strategy2.hpp"
+
+static uint64_t g_nAllocations = 0;
+
+void*
+operator new(std::size_t size)
+{
+  ++g_nAllocations;
+  if (void* memory = std::malloc(size))
+    return memory;
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+namespace nfd {
+namespace sim {
+
+static void
+benchmarkStrategy(Report& report, const std::string& label, const Name& strategyName,
+                  int nOperations)
+{
+  const Name prefix("/bench");
+
+  Simulator simulator;
+  simulator.setStrategy(prefix, strategyName);
+  for (int i = 0; i < 4; ++i)
+    simulator.addUpstream(prefix, UpstreamProfile{time::milliseconds(0), 0, 0});
+
+  // warm up measurement state before timing
+  for (int i = 0; i < 1000; ++i)
+    {
+      simulator.expressInterest(prefix);
+      simulator.advance(time::milliseconds(1));
+    }
+
+  const uint64_t allocationsBefore = g_nAllocations;
+  const auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < nOperations; ++i)
+    {
+      simulator.expressInterest(prefix);
+      simulator.advance(time::milliseconds(1));
+    }
+
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const uint64_t allocations = g_nAllocations - allocationsBefore;
+
+  const double nanoseconds =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+  report.set(label + "/interest-data/ns_per_op", nanoseconds / nOperations);
+  report.set(label + "/interest-data/allocs_per_op",
+             static_cast<double>(allocations) / nOperations);
+}
+
+} // namespace sim
+} // namespace nfd
+
+int
+main(int argc, char** argv)
+{
+  using namespace nfd;
+  using namespace nfd::sim;
+
+  const int nOperations = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+  Report report;
+  benchmarkStrategy(report, "best-route", fw::BestRouteStrategy2::STRATEGY_NAME, nOperations);
+  benchmarkStrategy(report, "weighted-load-balancer",
+                    fw::WeightedLoadBalancerStrategy::STRATEGY_NAME, nOperations);
+  benchmarkStrategy(report, "random-load-balancer",
+                    fw::RandomLoadBalancerStrategy::STRATEGY_NAME, nOperations);
+
+  report.print(std::cout);
+  return 0;
+}
@@ -0,0 +1,328 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  Face-churn benchmark for the weighted strategy's next-hop reconciliation.
+ *
+ *  The first part calls MyMeasurementInfo::updateStoredNextHops directly
+ *  for many prefixes while nexthops are added and removed at the given
+ *  rates, and reports the cost of updates that change the set and of
+ *  updates that do not, plus the cost of picking the best face afterwards.
+ *  The second part runs the full forwarding path: FIB nexthops churn while
+ *  Interests flow, and the strategy reconciles on every Interest.
+ *
+ *  Both parts check that every face surviving a change keeps the delay it
+ *  had measured before; the exit status is 1 if any history was lost.
+ *
+ *  Usage: strategy-churn [add-rate] [remove-rate] [prefixes] [rounds]
+ *
+ *  Rates are the probabilities that a prefix gains or loses one nexthop
+ *  in a round.
+ */
+
+#include <chrono>
+
+#include "strategy-simulator.hpp"
+
+#include "fw/weighted-load-balancer-strategy.hpp"
+
+namespace nfd {
+namespace sim {
+
+using fw::MyMeasurementInfo;
+
+static const size_t N_UPSTREAMS = 64;
+static const size_t MAX_NEXTHOPS_PER_PREFIX = 8;
+
+typedef std::chrono::steady_clock WallClock;
+
+struct ChurnResult
+{
+  size_t nChangedUpdates = 0;
+  size_t nUnchangedUpdates = 0;
+  double changedNs = 0;
+  double unchangedNs = 0;
+  double selectionNs = 0;
+  size_t nSurvivorsChecked = 0;
+  size_t nHistoryLost = 0;
+};
+
+/** \brief add or remove one nexthop of \p nexthops at random
+ *  \return whether \p nexthops changed
+ */
+static bool
+churnNextHops(fib::NextHopList& nexthops,
+              const std::vector<shared_ptr<SimulatedFace>>& upstreams,
+              double addRate, double removeRate, std::mt19937& random)
+{
+  bool isChanged = false;
+
+  std::bernoulli_distribution isRemoved(removeRate);
+  if (nexthops.size() > 1 && isRemoved(random))
+    {
+      std::uniform_int_distribution<size_t> pick(0, nexthops.size() - 1);
+      nexthops.erase(nexthops.begin() + pick(random));
+      isChanged = true;
+    }
+
+  std::bernoulli_distribution isAdded(addRate);
+  if (nexthops.size() < MAX_NEXTHOPS_PER_PREFIX && isAdded(random))
+    {
+      std::uniform_int_distribution<size_t> pick(0, upstreams.size() - 1);
+      const auto& face = upstreams[pick(random)];
+      if (std::none_of(nexthops.begin(), nexthops.end(),
+                       [&face] (const fib::NextHop& hop) { return hop.getFace() == face; }))
+        {
+          nexthops.push_back(fib::NextHop(face));
+          isChanged = true;
+        }
+    }
+
+  return isChanged;
+}
+
+static std::map<FaceId, time::milliseconds>
+snapshotDelays(const MyMeasurementInfo& info)
+{
+  std::map<FaceId, time::milliseconds> delays;
+  for (const auto& weightedFace : *info.weightedFaces)
+    delays[weightedFace.getId()] = weightedFace.lastDelay;
+  return delays;
+}
+
+/** \brief compare the delays of faces present both in \p before and in \p info
+ */
+static void
+checkSurvivors(const std::map<FaceId, time::milliseconds>& before,
+               const MyMeasurementInfo& info, ChurnResult& result)
+{
+  for (const auto& weightedFace : *info.weightedFaces)
+    {
+      auto it = before.find(weightedFace.getId());
+      if (it == before.end())
+        continue;
+
+      ++result.nSurvivorsChecked;
+      if (it->second != weightedFace.lastDelay)
+        ++result.nHistoryLost;
+    }
+}
+
+/** \brief reconciliation in isolation, without a forwarding path
+ */
+static ChurnResult
+runReconciliation(double addRate, double removeRate, size_t nPrefixes, size_t nRounds)
+{
+  Simulator simulator(1);
+  std::mt19937& random = simulator.getRandom();
+
+  std::vector<shared_ptr<SimulatedFace>> upstreams;
+  for (size_t i = 0; i < N_UPSTREAMS; ++i)
+    upstreams.push_back(simulator.addUpstream(UpstreamProfile()));
+
+  std::vector<fib::NextHopList> nexthops(nPrefixes);
+  std::vector<MyMeasurementInfo> infos(nPrefixes);
+  for (size_t i = 0; i < nPrefixes; ++i)
+    {
+      while (nexthops[i].size() < 3)
+        churnNextHops(nexthops[i], upstreams, 1, 0, random);
+      infos[i].updateStoredNextHops(nexthops[i]);
+    }
+
+  ChurnResult result;
+  std::uniform_int_distribution<int> delay(1, 500);
+  for (size_t round = 0; round < nRounds; ++round)
+    {
+      for (size_t i = 0; i < nPrefixes; ++i)
+        {
+          MyMeasurementInfo& info = infos[i];
+
+          // measurements arrive between updates, as Data would bring them
+          for (const auto& hop : nexthops[i])
+            info.updateFaceDelay(*hop.getFace(), time::milliseconds(delay(random)));
+
+          const bool isChanged = churnNextHops(nexthops[i], upstreams, addRate, removeRate, random);
+          const auto before = snapshotDelays(info);
+
+          auto start = WallClock::now();
+          info.updateStoredNextHops(nexthops[i]);
+          auto elapsed = WallClock::now() - start;
+
+          const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+          if (isChanged)
+            {
+              ++result.nChangedUpdates;
+              result.changedNs += ns;
+            }
+          else
+            {
+              ++result.nUnchangedUpdates;
+              result.unchangedNs += ns;
+            }
+
+          // selection reads the face with the lowest delay
+          start = WallClock::now();
+          auto& byDelay = info.weightedFaces->get<MyMeasurementInfo::ByDelay>();
+          volatile FaceId best = byDelay.empty() ? INVALID_FACEID : byDelay.begin()->getId();
+          (void)best;
+          result.selectionNs += std::chrono::duration<double, std::nano>(WallClock::now() - start).count();
+
+          checkSurvivors(before, info, result);
+          if (info.weightedFaces->size() != nexthops[i].size())
+            ++result.nHistoryLost;
+        }
+    }
+
+  return result;
+}
+
+/** \brief full forwarding path: FIB nexthops churn while Interests flow
+ */
+static ChurnResult
+runForwarding(double addRate, double removeRate, size_t nPrefixes, size_t nRounds,
+              Report& report, const std::string& label)
+{
+  Simulator simulator(1);
+  simulator.setKeepSamples(false);
+  simulator.setStrategy("/churn", fw::WeightedLoadBalancerStrategy::STRATEGY_NAME);
+  std::mt19937& random = simulator.getRandom();
+
+  std::vector<shared_ptr<SimulatedFace>> upstreams;
+  std::uniform_int_distribution<int> delay(5, 100);
+  for (size_t i = 0; i < N_UPSTREAMS; ++i)
+    upstreams.push_back(simulator.addUpstream(UpstreamProfile{time::milliseconds(delay(random)),
+                                                              0, 0}));
+
+  Forwarder& forwarder = simulator.getForwarder();
+  std::vector<Name> prefixes;
+  std::vector<fib::NextHopList> nexthops(nPrefixes);
+  for (size_t i = 0; i < nPrefixes; ++i)
+    {
+      prefixes.push_back(Name("/churn").appendNumber(i));
+      while (nexthops[i].size() < 3)
+        churnNextHops(nexthops[i], upstreams, 1, 0, random);
+      for (const auto& hop : nexthops[i])
+        simulator.addNextHop(prefixes[i], hop.getFace());
+    }
+
+  ChurnResult result;
+  for (size_t round = 0; round < nRounds; ++round)
+    {
+      for (size_t i = 0; i < nPrefixes; ++i)
+        {
+          const fib::NextHopList old = nexthops[i];
+          const bool isChanged = churnNextHops(nexthops[i], upstreams, addRate, removeRate, random);
+          if (isChanged)
+            {
+              auto fibEntry = forwarder.getFib().findExactMatch(prefixes[i]);
+              for (const auto& hop : old)
+                fibEntry->removeNextHop(hop.getFace());
+              for (const auto& hop : nexthops[i])
+                fibEntry->addNextHop(hop.getFace(), 0);
+            }
+
+          std::map<FaceId, time::milliseconds> before;
+          auto measurementsEntry = forwarder.getMeasurements().findExactMatch(prefixes[i]);
+          MyMeasurementInfo* info = measurementsEntry == nullptr ? nullptr :
+            measurementsEntry->getStrategyInfo<MyMeasurementInfo>().get();
+          if (info != nullptr)
+            before = snapshotDelays(*info);
+
+          // the strategy reconciles synchronously while receiving the Interest
+          auto start = WallClock::now();
+          simulator.expressInterest(prefixes[i]);
+          const double ns =
+            std::chrono::duration<double, std::nano>(WallClock::now() - start).count();
+
+          if (isChanged)
+            {
+              ++result.nChangedUpdates;
+              result.changedNs += ns;
+            }
+          else
+            {
+              ++result.nUnchangedUpdates;
+              result.unchangedNs += ns;
+            }
+
+          if (info != nullptr)
+            checkSurvivors(before, *info, result);
+        }
+
+      simulator.advance(time::milliseconds(100));
+    }
+  simulator.advance(time::milliseconds(5000));
+
+  const Metrics& metrics = simulator.getMetrics();
+  report.set(label + "/satisfaction", metrics.nInterests > 0 ?
+             static_cast<double>(metrics.nData) / metrics.nInterests : 0);
+  return result;
+}
+
+static void
+reportChurn(Report& report, const std::string& label, const ChurnResult& result)
+{
+  report.set(label + "/changed_updates", result.nChangedUpdates);
+  report.set(label + "/unchanged_updates", result.nUnchangedUpdates);
+  report.set(label + "/ns_per_changed_update", result.nChangedUpdates > 0 ?
+             result.changedNs / result.nChangedUpdates : 0);
+  report.set(label + "/ns_per_unchanged_update", result.nUnchangedUpdates > 0 ?
+             result.unchangedNs / result.nUnchangedUpdates : 0);
+  report.set(label + "/survivors_checked", result.nSurvivorsChecked);
+  report.set(label + "/history_lost", result.nHistoryLost);
+}
+
+} // namespace sim
+} // namespace nfd
+
+int
+main(int argc, char** argv)
+{
+  using namespace nfd;
+  using namespace nfd::sim;
+
+  const double addRate = argc > 1 ? std::atof(argv[1]) : 0.1;
+  const double removeRate = argc > 2 ? std::atof(argv[2]) : 0.1;
+  const size_t nPrefixes = argc > 3 ? std::atoll(argv[3]) : 10000;
+  const size_t nRounds = argc > 4 ? std::atoll(argv[4]) : 50;
+
+  Report report;
+  report.set("add_rate", addRate);
+  report.set("remove_rate", removeRate);
+  report.set("prefixes", nPrefixes);
+  report.set("rounds", nRounds);
+
+  const ChurnResult reconciliation = runReconciliation(addRate, removeRate, nPrefixes, nRounds);
+  reportChurn(report, "reconciliation", reconciliation);
+  report.set("reconciliation/ns_per_selection",
+             reconciliation.selectionNs / (nPrefixes * nRounds));
+
+  const ChurnResult forwarding = runForwarding(addRate, removeRate, nPrefixes / 10, nRounds,
+                                               report, "forwarding");
+  reportChurn(report, "forwarding", forwarding);
+
+  report.print(std::cout);
+  return reconciliation.nHistoryLost + forwarding.nHistoryLost > 0 ? 1 : 0;
+}
@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  Injects faults into one of three upstreams and measures how long each
+ *  strategy takes to recover.
+ *
+ *  The baseline satisfaction ratio and p99 latency are taken over the
+ *  seconds before the fault.  Time-to-recover is the time from the fault
+ *  until every later window is back within tolerance of the baseline (-1
+ *  if the run ends first); Interests lost counts timeouts of Interests
+ *  sent after the fault.
+ *
+ *  Usage: strategy-recovery [fault...]
+ */
+
+#include <set>
+
+#include "strategy-scenarios.hpp"
+
+namespace nfd {
+namespace sim {
+
+static const time::milliseconds FAULT_AT(10000);
+static const double WINDOW_MS = 250;
+static const double SATISFACTION_TOLERANCE = 0.01;
+static const double P99_TOLERANCE = 0.2;
+
+static std::vector<Scenario>
+makeFaults()
+{
+  using time::milliseconds;
+
+  const std::vector<UpstreamProfile> upstreams = {
+    {milliseconds(10), 0, 0},
+    {milliseconds(20), 0, 0},
+    {milliseconds(30), 0, 0},
+  };
+
+  std::vector<Scenario> faults;
+
+  faults.push_back({"face-down", upstreams, 300, milliseconds(40000),
+                    {{FAULT_AT, [] (ScenarioContext& context) {
+                        context.upstreams[0]->close();
+                      }}}});
+
+  faults.push_back({"slowdown", upstreams, 300, milliseconds(40000),
+                    {{FAULT_AT, [] (ScenarioContext& context) {
+                        context.upstreams[0]->profile.delay *= 10;
+                      }}}});
+
+  faults.push_back({"loss", upstreams, 300, milliseconds(40000),
+                    {{FAULT_AT, [] (ScenarioContext& context) {
+                        context.upstreams[0]->profile.loss = 0.3;
+                      }}}});
+
+  // the upstream goes dark and comes back every second for ten seconds
+  Scenario flapping{"flapping", upstreams, 300, milliseconds(40000), {}};
+  for (int i = 0; i < 10; ++i)
+    {
+      const double loss = i % 2 == 0 ? 1.0 : 0.0;
+      flapping.events.push_back({FAULT_AT + milliseconds(1000 * i),
+                                 [loss] (ScenarioContext& context) {
+                                   context.upstreams[0]->profile.loss = loss;
+                                 }});
+    }
+  flapping.events.push_back({FAULT_AT + milliseconds(10000), [] (ScenarioContext& context) {
+        context.upstreams[0]->profile.loss = 0;
+      }});
+  faults.push_back(flapping);
+
+  return faults;
+}
+
+struct Window
+{
+  size_t nSatisfied = 0;
+  size_t nTimeouts = 0;
+  std::vector<double> latencies;
+
+  double
+  satisfaction() const
+  {
+    const size_t total = nSatisfied + nTimeouts;
+    return total > 0 ? static_cast<double>(nSatisfied) / total : 1.0;
+  }
+
+  double
+  p99()
+  {
+    if (latencies.empty())
+      return 0;
+    std::sort(latencies.begin(), latencies.end());
+    return latencies[static_cast<size_t>(0.99 * (latencies.size() - 1) + 0.5)];
+  }
+};
+
+static void
+reportRecovery(Report& report, const std::string& label, const Metrics& metrics)
+{
+  const double faultMs = Simulator::toMs(FAULT_AT);
+
+  // the first two seconds are warm-up
+  Window baseline;
+  std::map<int64_t, Window> windows;
+  for (const auto& sample : metrics.samples)
+    {
+      if (sample.first >= 2000 && sample.first < faultMs)
+        {
+          ++baseline.nSatisfied;
+          baseline.latencies.push_back(sample.second);
+        }
+      else if (sample.first >= faultMs)
+        {
+          auto& window = windows[static_cast<int64_t>((sample.first - faultMs) / WINDOW_MS)];
+          ++window.nSatisfied;
+          window.latencies.push_back(sample.second);
+        }
+    }
+
+  size_t nLost = 0;
+  for (double sent : metrics.timeouts)
+    {
+      if (sent >= 2000 && sent < faultMs)
+        ++baseline.nTimeouts;
+      else if (sent >= faultMs)
+        {
+          ++windows[static_cast<int64_t>((sent - faultMs) / WINDOW_MS)].nTimeouts;
+          ++nLost;
+        }
+    }
+
+  const double baseSatisfaction = baseline.satisfaction();
+  const double baseP99 = baseline.p99();
+
+  double recoveryMs = 0;
+  for (auto& window : windows)
+    {
+      if (window.second.satisfaction() < baseSatisfaction - SATISFACTION_TOLERANCE ||
+          window.second.p99() > baseP99 * (1 + P99_TOLERANCE))
+        recoveryMs = (window.first + 1) * WINDOW_MS;
+    }
+
+  if (!windows.empty() && recoveryMs >= (windows.rbegin()->first + 1) * WINDOW_MS)
+    recoveryMs = -1;
+
+  report.set(label + "/baseline_satisfaction", baseSatisfaction);
+  report.set(label + "/baseline_p99_ms", baseP99);
+  report.set(label + "/recovery_ms", recoveryMs);
+  report.set(label + "/interests_lost", nLost);
+}
+
+} // namespace sim
+} // namespace nfd
+
+int
+main(int argc, char** argv)
+{
+  using namespace nfd;
+  using namespace nfd::sim;
+
+  std::set<std::string> selected(argv + 1, argv + argc);
+
+  Report report;
+  for (const auto& fault : makeFaults())
+    {
+      if (!selected.empty() && selected.count(fault.name) == 0)
+        continue;
+
+      for (const auto& strategy : makeStrategiesUnderTest())
+        {
+          reportRecovery(report, strategy.label + "/" + fault.name,
+                         runScenario(fault, strategy).metrics);
+        }
+    }
+
+  report.print(std::cout);
+  return 0;
+}
@@ -0,0 +1,407 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  Replays a strategy log written with the record=PATH strategy parameter.
+ *
+ *  The strategy named in the log is created with the recorded RNG seed and
+ *  driven with the recorded callbacks: virtual clocks are set to the
+ *  recorded times, faces are created with the recorded FaceIds, the FIB
+ *  entry is brought to the recorded nexthops and the PIT is kept in step
+ *  the way the forwarder would.  The replayed strategy records its own log,
+ *  which is then compared with the original record by record; they are
+ *  identical when the replay is faithful.  A log of an instance with
+ *  features whose inputs are not recorded (load weighting, shared face
+ *  records, probes, prefetching, the latency model) is refused, see
+ *  StrategyRecorder::makeRecordedName.  Run it under a profiler to
+ *  study a recorded episode offline, or stop after a number of input
+ *  records to bisect it.
+ *
+ *  Usage: strategy-replay LOG [OUTPUT-LOG] [input-records]
+ */
+
+#include <chrono>
+#include <limits>
+
+#include "strategy-simulator.hpp"
+
+#include "fw/strategy-recorder.hpp"
+#include "fw/weighted-load-balancer-strategy.hpp"
+#include "fw/random-load-balancer-strategy.hpp"
+
+namespace nfd {
+namespace sim {
+
+using fw::StrategyLogReader;
+
+/** \brief a face that only stands in for a recorded FaceId
+ */
+class ReplayFace : public Face
+{
+public:
+  explicit
+  ReplayFace(bool isLocal)
+    : Face(FaceUri("null://"), FaceUri("null://"), isLocal)
+  {
+  }
+
+  virtual void
+  sendInterest(const Interest& interest) DECL_OVERRIDE
+  {
+  }
+
+  virtual void
+  sendData(const Data& data) DECL_OVERRIDE
+  {
+  }
+
+  virtual void
+  close() DECL_OVERRIDE
+  {
+    this->fail("close");
+  }
+};
+
+struct ReplayResult
+{
+  uint64_t nInputs = 0;
+  uint64_t nInterests = 0;
+  uint64_t nData = 0;
+  uint64_t nExpiries = 0;
+  uint64_t nMissingPitEntries = 0;
+  double callbackNs = 0;
+};
+
+class Replay : noncopyable
+{
+public:
+  Replay(const std::string& logPath, const std::string& outputPath)
+    : m_log(logPath)
+    , m_steadyClock(make_shared<ndn::time::UnitTestSteadyClock>())
+    , m_systemClock(make_shared<ndn::time::UnitTestSystemClock>())
+  {
+    ndn::time::setCustomClocks(m_steadyClock, m_systemClock);
+    createFaces(logPath);
+
+    const Name& name = m_log.getStrategyName();
+    const std::string unrecorded = fw::StrategyRecorder::UNRECORDED_PARAMETER + "=";
+    for (const auto& component : name)
+      {
+        const std::string parameter(reinterpret_cast<const char*>(component.value()),
+                                    component.value_size());
+        if (parameter.compare(0, unrecorded.size(), unrecorded) == 0)
+          throw StrategyLogReader::Error("the log does not hold the inputs of " +
+                                         parameter.substr(unrecorded.size()) +
+                                         ", it cannot be replayed exactly");
+      }
+
+    Name instanceName(name);
+    instanceName.append(name::Component("seed=" + std::to_string(m_log.getSeed())))
+                .append(name::Component("record=" + outputPath));
+
+    if (fw::WeightedLoadBalancerStrategy::STRATEGY_NAME.isPrefixOf(name))
+      m_strategy = make_shared<fw::WeightedLoadBalancerStrategy>(ref(m_forwarder), instanceName);
+    else if (fw::RandomLoadBalancerStrategy::STRATEGY_NAME.isPrefixOf(name))
+      m_strategy = make_shared<fw::RandomLoadBalancerStrategy>(ref(m_forwarder), instanceName);
+    else
+      throw StrategyLogReader::Error("no strategy to replay " + name.toUri());
+
+    m_forwarder.getStrategyChoice().install(m_strategy);
+    m_forwarder.getStrategyChoice().insert("/", instanceName);
+  }
+
+  ~Replay()
+  {
+    ndn::time::setCustomClocks(nullptr, nullptr);
+  }
+
+  ReplayResult
+  run(uint64_t maxInputs)
+  {
+    StrategyLogReader::Record record;
+    while (m_result.nInputs < maxInputs && m_log.read(record))
+      {
+        switch (record.type)
+          {
+          case fw::STRATEGY_RECORD_INTEREST:
+            setTime(record);
+            replayInterest(record);
+            break;
+          case fw::STRATEGY_RECORD_DATA:
+            setTime(record);
+            replayData(record);
+            break;
+          case fw::STRATEGY_RECORD_EXPIRE:
+            setTime(record);
+            replayExpire(record);
+            break;
+          default:
+            // faces exist already and decisions are recorded by the replayed strategy
+            break;
+          }
+      }
+    return m_result;
+  }
+
+private:
+  /** \brief create every face of the log with its recorded FaceId
+   */
+  void
+  createFaces(const std::string& logPath)
+  {
+    std::map<FaceId, bool> isLocal;
+    StrategyLogReader log(logPath);
+    StrategyLogReader::Record record;
+    while (log.read(record))
+      {
+        if (record.type == fw::STRATEGY_RECORD_FACE)
+          isLocal[record.faceId] = record.isLocal;
+      }
+
+    for (const auto& face : isLocal)
+      {
+        auto replayFace = make_shared<ReplayFace>(face.second);
+        if (face.first <= FACEID_RESERVED_MAX)
+          {
+            m_forwarder.getFaceTable().addReserved(replayFace, face.first);
+          }
+        else
+          {
+            // FaceIds are assigned in sequence, so pad up to the recorded one
+            for (m_forwarder.addFace(replayFace); replayFace->getId() < face.first;
+                 m_forwarder.addFace(replayFace))
+              {
+                m_fillers.push_back(replayFace);
+                replayFace = make_shared<ReplayFace>(face.second);
+              }
+          }
+
+        if (replayFace->getId() != face.first)
+          throw StrategyLogReader::Error("cannot recreate FaceId " + std::to_string(face.first));
+        m_faces[face.first] = replayFace;
+      }
+  }
+
+  void
+  setTime(const StrategyLogReader::Record& record)
+  {
+    m_steadyClock->setNow(record.steadyTime.time_since_epoch());
+    m_systemClock->setNow(record.systemTime.time_since_epoch());
+
+    // timers of the forwarder, Measurements and the strategy due by now
+    boost::asio::io_service& io = getGlobalIoService();
+    if (io.stopped())
+      io.reset();
+    io.poll();
+
+    ++m_result.nInputs;
+  }
+
+  void
+  replayInterest(const StrategyLogReader::Record& record)
+  {
+    ++m_result.nInterests;
+    Face& inFace = *m_faces.at(record.faceId);
+
+    // bring the FIB entry to the recorded nexthops, in the recorded order
+    auto fibEntry = m_forwarder.getFib().insert(record.prefix).first;
+    const fib::NextHopList& nexthops = fibEntry->getNextHops();
+    bool isSame = nexthops.size() == record.nexthops.size();
+    for (size_t i = 0; isSame && i < nexthops.size(); ++i)
+      {
+        isSame = nexthops[i].getFace()->getId() == record.nexthops[i].first &&
+                 nexthops[i].getCost() == record.nexthops[i].second;
+      }
+    if (!isSame)
+      {
+        while (!fibEntry->getNextHops().empty())
+          fibEntry->removeNextHop(fibEntry->getNextHops().front().getFace());
+        for (const auto& hop : record.nexthops)
+          fibEntry->addNextHop(m_faces.at(hop.first), hop.second);
+      }
+
+    // what Forwarder::onIncomingInterest does before the strategy is called
+    auto pitEntry = m_forwarder.getPit().insert(*record.interest).first;
+    scheduler::cancel(pitEntry->m_stragglerTimer);
+    pitEntry->insertOrUpdateInRecord(inFace.shared_from_this(), *record.interest);
+
+    const auto start = std::chrono::steady_clock::now();
+    m_strategy->afterReceiveInterest(inFace, *record.interest, fibEntry, pitEntry);
+    addCallbackTime(start);
+  }
+
+  void
+  replayData(const StrategyLogReader::Record& record)
+  {
+    ++m_result.nData;
+    Face& inFace = *m_faces.at(record.faceId);
+
+    auto pitEntry = m_forwarder.getPit().find(*record.interest);
+    if (pitEntry == nullptr)
+      {
+        ++m_result.nMissingPitEntries;
+        return;
+      }
+
+    Data data(record.dataName);
+    const auto start = std::chrono::steady_clock::now();
+    m_strategy->beforeSatisfyInterest(pitEntry, inFace, data);
+    addCallbackTime(start);
+
+    // what Forwarder::onIncomingData does afterwards
+    pitEntry->deleteInRecords();
+    pitEntry->deleteOutRecord(inFace);
+    scheduler::cancel(pitEntry->m_unsatisfyTimer);
+    scheduler::cancel(pitEntry->m_stragglerTimer);
+    Pit& pit = m_forwarder.getPit();
+    pitEntry->m_stragglerTimer = scheduler::schedule(time::milliseconds(100), [&pit, pitEntry] {
+        pit.erase(pitEntry);
+      });
+  }
+
+  void
+  replayExpire(const StrategyLogReader::Record& record)
+  {
+    ++m_result.nExpiries;
+
+    auto pitEntry = m_forwarder.getPit().find(*record.interest);
+    if (pitEntry == nullptr)
+      {
+        ++m_result.nMissingPitEntries;
+        return;
+      }
+
+    const auto start = std::chrono::steady_clock::now();
+    m_strategy->beforeExpirePendingInterest(pitEntry);
+    addCallbackTime(start);
+
+    scheduler::cancel(pitEntry->m_stragglerTimer);
+    m_forwarder.getPit().erase(pitEntry);
+  }
+
+  void
+  addCallbackTime(const std::chrono::steady_clock::time_point& start)
+  {
+    m_result.callbackNs +=
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  }
+
+private:
+  StrategyLogReader m_log;
+  shared_ptr<ndn::time::UnitTestSteadyClock> m_steadyClock;
+  shared_ptr<ndn::time::UnitTestSystemClock> m_systemClock;
+
+  Forwarder m_forwarder;
+  shared_ptr<fw::Strategy> m_strategy;
+  std::map<FaceId, shared_ptr<ReplayFace>> m_faces;
+  std::vector<shared_ptr<ReplayFace>> m_fillers;
+
+  ReplayResult m_result;
+};
+
+static bool
+isSameRecord(const StrategyLogReader::Record& a, const StrategyLogReader::Record& b)
+{
+  return a.type == b.type &&
+         a.steadyTime == b.steadyTime &&
+         a.systemTime == b.systemTime &&
+         a.faceId == b.faceId &&
+         a.isLocal == b.isLocal &&
+         (a.interest == nullptr) == (b.interest == nullptr) &&
+         (a.interest == nullptr || a.interest->wireEncode() == b.interest->wireEncode()) &&
+         a.prefix == b.prefix &&
+         a.nexthops == b.nexthops &&
+         a.dataName == b.dataName;
+}
+
+/** \return index of the first record that differs, -1 if \p replayed is
+ *          identical to the start of \p original
+ */
+static int64_t
+findDivergence(const std::string& original, const std::string& replayed)
+{
+  StrategyLogReader originalLog(original);
+  StrategyLogReader replayedLog(replayed);
+  if (originalLog.getStrategyName() != replayedLog.getStrategyName() ||
+      originalLog.getSeed() != replayedLog.getSeed())
+    return 0;
+
+  StrategyLogReader::Record originalRecord;
+  StrategyLogReader::Record replayedRecord;
+  for (int64_t index = 0; replayedLog.read(replayedRecord); ++index)
+    {
+      if (!originalLog.read(originalRecord) || !isSameRecord(originalRecord, replayedRecord))
+        return index;
+    }
+  return -1;
+}
+
+} // namespace sim
+} // namespace nfd
+
+int
+main(int argc, char** argv)
+{
+  using namespace nfd;
+  using namespace nfd::sim;
+
+  if (argc < 2)
+    {
+      std::cerr << "Usage: " << argv[0] << " LOG [OUTPUT-LOG] [input-records]" << std::endl;
+      return 2;
+    }
+
+  const std::string logPath = argv[1];
+  const std::string outputPath = argc > 2 ? argv[2] : logPath + ".replay";
+  const uint64_t maxInputs = argc > 3 ? std::strtoull(argv[3], nullptr, 10) :
+                                        std::numeric_limits<uint64_t>::max();
+
+  ReplayResult result;
+  try
+    {
+      // the replayed strategy's log is complete once the Replay is gone
+      Replay replay(logPath, outputPath);
+      result = replay.run(maxInputs);
+    }
+  catch (const std::exception& e)
+    {
+      std::cerr << "ERROR: " << e.what() << std::endl;
+      return 2;
+    }
+
+  const int64_t divergence = findDivergence(logPath, outputPath);
+
+  Report report;
+  report.set("input_records", result.nInputs);
+  report.set("interests", result.nInterests);
+  report.set("data", result.nData);
+  report.set("expiries", result.nExpiries);
+  report.set("missing_pit_entries", result.nMissingPitEntries);
+  report.set("ns_per_callback", result.nInputs > 0 ? result.callbackNs / result.nInputs : 0);
+  report.set("diverged_at_record", divergence);
+  report.print(std::cout);
+
+  return divergence < 0 ? 0 : 1;
+}
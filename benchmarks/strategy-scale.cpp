@@ -0,0 +1,277 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  FIB-scale benchmark: each strategy with hundreds of thousands to
+ *  millions of prefixes.
+ *
+ *  For every FIB size the FIB is filled with prefixes of three nexthops
+ *  each, then a Zipf-distributed Interest workload runs across them.  The
+ *  program reports heap bytes per prefix after filling the FIB and after
+ *  the workload (which adds the strategy's Measurements state), Interest
+ *  and Data packets per wall-clock second, and the hardware cache miss
+ *  rate during the workload.  Cache counters come from perf_event_open
+ *  and are reported as -1 where the kernel does not allow it (check
+ *  /proc/sys/kernel/perf_event_paranoid).
+ *
+ *  Usage: strategy-scale [weighted|random|all] [interests] [zipf-exponent] [prefixes...]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <malloc.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "strategy-simulator.hpp"
+
+#include "fw/weighted-load-balancer-strategy.hpp"
+#include "fw/random-load-balancer-strategy.hpp"
+
+static int64_t g_nLiveHeapBytes = 0;
+
+void*
+operator new(std::size_t size)
+{
+  if (void* memory = std::malloc(size))
+    {
+      g_nLiveHeapBytes += malloc_usable_size(memory);
+      return memory;
+    }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* memory) noexcept
+{
+  if (memory != nullptr)
+    g_nLiveHeapBytes -= malloc_usable_size(memory);
+  std::free(memory);
+}
+
+namespace nfd {
+namespace sim {
+
+static const size_t N_UPSTREAMS = 32;
+static const size_t N_NEXTHOPS_PER_PREFIX = 3;
+static const size_t N_INTERESTS_PER_TICK = 100;
+
+/** \brief draws ranks 0..n-1 with probability proportional to 1/(rank+1)^s
+ */
+class ZipfDistribution
+{
+public:
+  ZipfDistribution(size_t n, double s)
+    : m_cdf(n)
+  {
+    double sum = 0;
+    for (size_t rank = 0; rank < n; ++rank)
+      {
+        sum += 1.0 / std::pow(rank + 1, s);
+        m_cdf[rank] = sum;
+      }
+    for (auto& value : m_cdf)
+      value /= sum;
+  }
+
+  size_t
+  operator()(std::mt19937& random) const
+  {
+    std::uniform_real_distribution<double> uniform(0, 1);
+    auto it = std::lower_bound(m_cdf.begin(), m_cdf.end(), uniform(random));
+    return std::min<size_t>(it - m_cdf.begin(), m_cdf.size() - 1);
+  }
+
+private:
+  std::vector<double> m_cdf;
+};
+
+/** \brief a hardware counter of the calling thread, or -1 when unavailable
+ */
+class HardwareCounter : noncopyable
+{
+public:
+  explicit
+  HardwareCounter(uint64_t config)
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    m_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+
+  ~HardwareCounter()
+  {
+    if (m_fd >= 0)
+      close(m_fd);
+  }
+
+  void
+  start()
+  {
+    if (m_fd >= 0)
+      {
+        ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+  }
+
+  double
+  stop()
+  {
+    uint64_t count = 0;
+    if (m_fd < 0)
+      return -1;
+
+    ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(m_fd, &count, sizeof(count)) != sizeof(count))
+      return -1;
+    return static_cast<double>(count);
+  }
+
+private:
+  int m_fd;
+};
+
+static void
+benchmarkScale(Report& report, const std::string& label, const Name& strategyName,
+               size_t nPrefixes, size_t nInterests, const ZipfDistribution& zipf)
+{
+  const int64_t heapBefore = g_nLiveHeapBytes;
+  const std::string prefixLabel = label + "/" + std::to_string(nPrefixes);
+
+  Simulator simulator(1);
+  simulator.setKeepSamples(false);
+  simulator.setStrategy("/scale", strategyName);
+  std::mt19937& random = simulator.getRandom();
+
+  std::vector<shared_ptr<SimulatedFace>> upstreams;
+  for (size_t i = 0; i < N_UPSTREAMS; ++i)
+    upstreams.push_back(simulator.addUpstream(UpstreamProfile{time::milliseconds(10 + i),
+                                                              0, 0}));
+
+  std::vector<Name> prefixes;
+  prefixes.reserve(nPrefixes);
+  for (size_t i = 0; i < nPrefixes; ++i)
+    prefixes.push_back(Name("/scale").appendNumber(i));
+  const int64_t heapWithNames = g_nLiveHeapBytes;
+
+  std::uniform_int_distribution<size_t> pickFace(0, N_UPSTREAMS - 1);
+  for (const Name& prefix : prefixes)
+    {
+      const size_t first = pickFace(random);
+      for (size_t i = 0; i < N_NEXTHOPS_PER_PREFIX; ++i)
+        simulator.addNextHop(prefix, upstreams[(first + i) % N_UPSTREAMS]);
+    }
+  const int64_t heapWithFib = g_nLiveHeapBytes;
+
+  HardwareCounter cacheReferences(PERF_COUNT_HW_CACHE_REFERENCES);
+  HardwareCounter cacheMisses(PERF_COUNT_HW_CACHE_MISSES);
+  cacheReferences.start();
+  cacheMisses.start();
+  const auto start = std::chrono::steady_clock::now();
+
+  for (size_t sent = 0; sent < nInterests; )
+    {
+      for (size_t i = 0; i < N_INTERESTS_PER_TICK && sent < nInterests; ++i, ++sent)
+        simulator.expressInterest(prefixes[zipf(random)]);
+
+      simulator.advance(time::milliseconds(1));
+    }
+  simulator.advance(time::milliseconds(1000));
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                       start).count();
+  const double misses = cacheMisses.stop();
+  const double references = cacheReferences.stop();
+  const int64_t heapAfterWorkload = g_nLiveHeapBytes;
+
+  const Metrics& metrics = simulator.getMetrics();
+  const double perPrefix = 1.0 / nPrefixes;
+
+  report.set(prefixLabel + "/fib_bytes_per_prefix", (heapWithFib - heapWithNames) * perPrefix);
+  report.set(prefixLabel + "/total_bytes_per_prefix",
+             (heapAfterWorkload - heapBefore) * perPrefix);
+  report.set(prefixLabel + "/measurements_entries", simulator.getForwarder().getMeasurements().size());
+  report.set(prefixLabel + "/interests_per_second", metrics.nInterests / seconds);
+  report.set(prefixLabel + "/data_per_second", metrics.nData / seconds);
+  report.set(prefixLabel + "/satisfaction", metrics.nInterests > 0 ?
+             static_cast<double>(metrics.nData) / metrics.nInterests : 0);
+  report.set(prefixLabel + "/cache_misses_per_interest",
+             misses < 0 ? -1 : misses / metrics.nInterests);
+  report.set(prefixLabel + "/cache_miss_rate",
+             misses < 0 || references <= 0 ? -1 : misses / references);
+}
+
+} // namespace sim
+} // namespace nfd
+
+int
+main(int argc, char** argv)
+{
+  using namespace nfd;
+  using namespace nfd::sim;
+
+  const std::string strategy = argc > 1 ? argv[1] : "all";
+  const size_t nInterests = argc > 2 ? std::atoll(argv[2]) : 1000000;
+  const double exponent = argc > 3 ? std::atof(argv[3]) : 1.0;
+
+  std::vector<size_t> sizes;
+  for (int i = 4; i < argc; ++i)
+    sizes.push_back(std::atoll(argv[i]));
+  if (sizes.empty())
+    sizes = {100000, 1000000, 5000000};
+
+  Report report;
+  for (size_t nPrefixes : sizes)
+    {
+      // built outside the measured runs so it is not counted per prefix
+      const ZipfDistribution zipf(nPrefixes, exponent);
+
+      if (strategy == "all" || strategy == "weighted")
+        benchmarkScale(report, "weighted-load-balancer",
+                       fw::WeightedLoadBalancerStrategy::STRATEGY_NAME,
+                       nPrefixes, nInterests, zipf);
+      if (strategy == "all" || strategy == "random")
+        benchmarkScale(report, "random-load-balancer",
+                       fw::RandomLoadBalancerStrategy::STRATEGY_NAME,
+                       nPrefixes, nInterests, zipf);
+    }
+
+  report.print(std::cout);
+  return 0;
+}
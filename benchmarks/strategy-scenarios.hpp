@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_TESTS_OTHER_STRATEGY_SCENARIOS_HPP
+#define NFD_TESTS_OTHER_STRATEGY_SCENARIOS_HPP
+
+#include <functional>
+
+#include "strategy-simulator.hpp"
+#include "stand-in-strategies.hpp"
+
+#include "fw/weighted-load-balancer-strategy.hpp"
+#include "fw/random-load-balancer-strategy.hpp"
+
+namespace nfd {
+namespace sim {
+
+/** \brief state a scenario event may change while it runs
+ */
+struct ScenarioContext
+{
+  Simulator& simulator;
+  std::vector<shared_ptr<SimulatedFace>> upstreams;
+  double rate;
+};
+
+struct Scenario
+{
+  std::string name;
+  std::vector<UpstreamProfile> upstreams;
+  double rate;
+  time::milliseconds duration;
+
+  /// actions applied once virtual time reaches the given offset
+  std::vector<std::pair<time::milliseconds, std::function<void(ScenarioContext&)>>> events;
+};
+
+/** \brief a strategy under evaluation
+ */
+struct StrategyUnderTest
+{
+  std::string label;
+  Name name;
+
+  /// creates the strategy if it is not installed by NFD itself
+  std::function<shared_ptr<fw::Strategy>(Forwarder&)> create;
+};
+
+struct ScenarioResult
+{
+  Metrics metrics;
+  double durationMs;
+
+  /// (Interests sent, capacity) per upstream
+  std::vector<std::pair<uint64_t, double>> upstreams;
+};
+
+inline ScenarioResult
+runScenario(const Scenario& scenario, const StrategyUnderTest& strategy)
+{
+  const Name prefix("/sim");
+
+  Simulator simulator;
+  if (strategy.create)
+    simulator.getForwarder().getStrategyChoice().install(strategy.create(simulator.getForwarder()));
+  simulator.setStrategy(prefix, strategy.name);
+
+  ScenarioContext context{simulator, {}, scenario.rate};
+  for (const auto& profile : scenario.upstreams)
+    context.upstreams.push_back(simulator.addUpstream(prefix, profile));
+
+  const time::milliseconds tick(1);
+  auto nextEvent = scenario.events.begin();
+  for (time::milliseconds elapsed(0); elapsed < scenario.duration; elapsed += tick)
+    {
+      for (; nextEvent != scenario.events.end() && nextEvent->first <= elapsed; ++nextEvent)
+        nextEvent->second(context);
+
+      simulator.run(prefix, context.rate, tick, tick);
+    }
+
+  // let outstanding Interests complete or expire
+  for (int i = 0; i < 5000; ++i)
+    simulator.advance(tick);
+
+  ScenarioResult result;
+  result.metrics = simulator.getMetrics();
+  result.durationMs = time::duration_cast<time::milliseconds>(scenario.duration).count();
+  for (const auto& face : context.upstreams)
+    result.upstreams.push_back(std::make_pair(face->nSentInterests, face->profile.capacity));
+
+  return result;
+}
+
+/// seed of the load balancers' RNG, so results are the same on every run
+static const std::string SCENARIO_SEED = "seed=1";
+
+/** \brief a weighted load balancer instance with the given parameters
+ *         and SCENARIO_SEED
+ */
+inline StrategyUnderTest
+makeWeightedVariant(const std::string& label, const std::vector<std::string>& parameters)
+{
+  Name name(fw::WeightedLoadBalancerStrategy::STRATEGY_NAME);
+  for (const auto& parameter : parameters)
+    name.append(name::Component(parameter));
+  name.append(name::Component(SCENARIO_SEED));
+
+  return {label, name, [name] (Forwarder& forwarder) {
+      return make_shared<fw::WeightedLoadBalancerStrategy>(ref(forwarder), name);
+    }};
+}
+
+/** \brief a random load balancer instance with the given parameters
+ *         and SCENARIO_SEED
+ */
+inline StrategyUnderTest
+makeRandomVariant(const std::string& label, const std::vector<std::string>& parameters)
+{
+  Name name(fw::RandomLoadBalancerStrategy::STRATEGY_NAME);
+  for (const auto& parameter : parameters)
+    name.append(name::Component(parameter));
+  name.append(name::Component(SCENARIO_SEED));
+
+  return {label, name, [name] (Forwarder& forwarder) {
+      return make_shared<fw::RandomLoadBalancerStrategy>(ref(forwarder), name);
+    }};
+}
+
+/** \brief the load balancers, their policy variants and the stand-ins
+ *         they are compared with
+ */
+inline std::vector<StrategyUnderTest>
+makeStrategiesUnderTest()
+{
+  return {
+    makeWeightedVariant("weighted-load-balancer", {}),
+    makeWeightedVariant("weighted-p2c-ewma", {"selector=p2c", "estimator=ewma"}),
+    makeWeightedVariant("weighted-ab-p2c-ewma", {"candidate-selector=p2c",
+                                                 "candidate-estimator=ewma",
+                                                 "candidate-fraction=0.5"}),
+    makeRandomVariant("random-load-balancer", {}),
+    makeRandomVariant("random-replicas-2", {"replicas=2"}),
+    {"best-route", BestRouteStandIn::STRATEGY_NAME,
+     [] (Forwarder& forwarder) { return make_shared<BestRouteStandIn>(ref(forwarder)); }},
+    {"multicast", MulticastStandIn::STRATEGY_NAME,
+     [] (Forwarder& forwarder) { return make_shared<MulticastStandIn>(ref(forwarder)); }},
+    {"asf", AsfStandIn::STRATEGY_NAME,
+     [] (Forwarder& forwarder) { return make_shared<AsfStandIn>(ref(forwarder)); }},
+  };
+}
+
+} // namespace sim
+} // namespace nfd
+
+#endif // NFD_TESTS_OTHER_STRATEGY_SCENARIOS_HPP
@@ -0,0 +1,155 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  Runs the strategies through simulated scenarios in virtual time and
+ *  prints a scorecard as JSON: throughput, latency percentiles,
+ *  satisfaction, convergence time, upstream Interest overhead and Jain's
+ *  fairness index of the load placed on each upstream relative to its
+ *  capacity.  Stand-ins for NFD's best-route, multicast and ASF strategies
+ *  run alongside the load balancers for comparison.
+ *
+ *  Usage: strategy-simulation [scenario...]
+ */
+
+#include <set>
+
+#include "strategy-scenarios.hpp"
+
+namespace nfd {
+namespace sim {
+
+static std::vector<Scenario>
+makeScenarios()
+{
+  using time::milliseconds;
+
+  std::vector<Scenario> scenarios;
+
+  scenarios.push_back({"heterogeneous-rtt",
+                       {{milliseconds(10), 0, 0},
+                        {milliseconds(50), 0, 0},
+                        {milliseconds(100), 0, 0}},
+                       300, milliseconds(20000), {}});
+
+  scenarios.push_back({"capacity-skew",
+                       {{milliseconds(20), 1000, 0},
+                        {milliseconds(20), 200, 0},
+                        {milliseconds(20), 100, 0}},
+                       800, milliseconds(20000), {}});
+
+  // the fastest upstream silently drops everything from 5s on
+  scenarios.push_back({"link-failure",
+                       {{milliseconds(10), 0, 0},
+                        {milliseconds(30), 0, 0},
+                        {milliseconds(50), 0, 0}},
+                       300, milliseconds(20000),
+                       {{milliseconds(5000), [] (ScenarioContext& context) {
+                           context.upstreams[0]->profile.loss = 1.0;
+                         }}}});
+
+  // load jumps fivefold between 5s and 10s
+  scenarios.push_back({"flash-crowd",
+                       {{milliseconds(20), 500, 0},
+                        {milliseconds(20), 500, 0},
+                        {milliseconds(20), 250, 0}},
+                       200, milliseconds(20000),
+                       {{milliseconds(5000), [] (ScenarioContext& context) {
+                           context.rate = 1000;
+                         }},
+                        {milliseconds(10000), [] (ScenarioContext& context) {
+                           context.rate = 200;
+                         }}}});
+
+  return scenarios;
+}
+
+/** \brief Jain's fairness index of upstream load normalised by capacity
+ *
+ *  Upstreams without a capacity limit count as equal.  1 means every
+ *  upstream carries load in proportion to what it can serve.
+ */
+static double
+computeFairness(const std::vector<std::pair<uint64_t, double>>& upstreams)
+{
+  double sum = 0;
+  double sumOfSquares = 0;
+  for (const auto& upstream : upstreams)
+    {
+      const double load = upstream.first / (upstream.second > 0 ? upstream.second : 1.0);
+      sum += load;
+      sumOfSquares += load * load;
+    }
+
+  return sumOfSquares > 0 ? sum * sum / (upstreams.size() * sumOfSquares) : 0;
+}
+
+static void
+reportScenario(Report& report, const std::string& label, const ScenarioResult& result)
+{
+  const Metrics& metrics = result.metrics;
+
+  uint64_t nUpstreamInterests = 0;
+  for (const auto& upstream : result.upstreams)
+    nUpstreamInterests += upstream.first;
+
+  report.set(label + "/throughput", metrics.nData * 1000.0 / result.durationMs);
+  report.set(label + "/p50_ms", metrics.percentile(0.50));
+  report.set(label + "/p99_ms", metrics.percentile(0.99));
+  report.set(label + "/convergence_ms", metrics.convergenceTime());
+  report.set(label + "/satisfaction",
+             metrics.nInterests > 0 ? static_cast<double>(metrics.nData) / metrics.nInterests : 0);
+  report.set(label + "/upstream_overhead",
+             metrics.nInterests > 0 ? static_cast<double>(nUpstreamInterests) / metrics.nInterests : 0);
+  report.set(label + "/fairness", computeFairness(result.upstreams));
+}
+
+} // namespace sim
+} // namespace nfd
+
+int
+main(int argc, char** argv)
+{
+  using namespace nfd;
+  using namespace nfd::sim;
+
+  std::set<std::string> selected(argv + 1, argv + argc);
+
+  Report report;
+  for (const auto& scenario : makeScenarios())
+    {
+      if (!selected.empty() && selected.count(scenario.name) == 0)
+        continue;
+
+      for (const auto& strategy : makeStrategiesUnderTest())
+        {
+          reportScenario(report, strategy.label + "/" + scenario.name,
+                         runScenario(scenario, strategy));
+        }
+    }
+
+  report.print(std::cout);
+  return 0;
+}
@@ -0,0 +1,492 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_TESTS_OTHER_STRATEGY_SIMULATOR_HPP
+#define NFD_TESTS_OTHER_STRATEGY_SIMULATOR_HPP
+
+#include <map>
+#include <random>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include <ndn-cxx/util/time-unit-test-clock.hpp>
+#include <ndn-cxx/security/signature-sha256-with-rsa.hpp>
+
+#include "core/global-io.hpp"
+#include "core/scheduler.hpp"
+#include "face/face.hpp"
+#include "fw/forwarder.hpp"
+
+namespace nfd {
+namespace sim {
+
+/** \brief behaviour of the producer behind a simulated upstream face
+ */
+struct UpstreamProfile
+{
+  /// one-way path plus processing delay added to every reply
+  time::milliseconds delay;
+
+  /// Data packets served per second, 0 for unlimited
+  double capacity;
+
+  /// probability that an Interest is silently dropped
+  double loss;
+};
+
+class Simulator;
+
+/** \brief a Face whose peer is simulated in virtual time
+ *
+ *  An upstream face answers every Interest it is asked to send after a
+ *  queueing delay derived from its UpstreamProfile.  The downstream face
+ *  stands for the consumer: Interests are injected through it and Data
+ *  sent to it is reported back to the Simulator.
+ */
+class SimulatedFace : public Face
+{
+public:
+  SimulatedFace(Simulator& simulator, const std::string& uri,
+                const UpstreamProfile& profile, bool isUpstream);
+
+  virtual void
+  sendInterest(const Interest& interest) DECL_OVERRIDE;
+
+  virtual void
+  sendData(const Data& data) DECL_OVERRIDE;
+
+  virtual void
+  close() DECL_OVERRIDE;
+
+  void
+  receiveInterest(const Interest& interest)
+  {
+    this->emitSignal(onReceiveInterest, interest);
+  }
+
+  void
+  receiveData(const Data& data)
+  {
+    this->emitSignal(onReceiveData, data);
+  }
+
+public:
+  UpstreamProfile profile;
+
+  /// Interests this face was asked to send
+  uint64_t nSentInterests;
+
+private:
+  Simulator& m_simulator;
+  bool m_isUpstream;
+  time::steady_clock::TimePoint m_nextFree;
+};
+
+/** \brief latency and traffic counters collected by the Simulator
+ */
+struct Metrics
+{
+  uint64_t nInterests = 0;
+  uint64_t nData = 0;
+  uint64_t nTimeouts = 0;
+
+  /// (send time since start, latency) of every satisfied Interest, in ms
+  std::vector<std::pair<double, double>> samples;
+
+  /// send time since start of every Interest that timed out, in ms
+  std::vector<double> timeouts;
+
+  /// satisfied Interests per upstream face
+  std::map<FaceId, uint64_t> servedBy;
+
+  double
+  percentile(double fraction) const
+  {
+    if (samples.empty())
+      return 0;
+
+    std::vector<double> latencies;
+    latencies.reserve(samples.size());
+    for (const auto& sample : samples)
+      latencies.push_back(sample.second);
+
+    std::sort(latencies.begin(), latencies.end());
+    return latencies[static_cast<size_t>(fraction * (latencies.size() - 1) + 0.5)];
+  }
+
+  /** \return time in ms after which the windowed mean latency stays within
+   *          \p tolerance of the mean over the last fifth of the run
+   */
+  double
+  convergenceTime(double windowMs = 100, double tolerance = 0.1) const
+  {
+    if (samples.empty())
+      return 0;
+
+    const double end = samples.back().first;
+    double steadySum = 0;
+    size_t steadyCount = 0;
+    for (const auto& sample : samples)
+      {
+        if (sample.first >= end * 0.8)
+          {
+            steadySum += sample.second;
+            ++steadyCount;
+          }
+      }
+    const double steady = steadySum / steadyCount;
+
+    // walk the windows backwards to find the last one out of range
+    std::map<int64_t, std::pair<double, size_t>> windows;
+    for (const auto& sample : samples)
+      {
+        auto& window = windows[static_cast<int64_t>(sample.first / windowMs)];
+        window.first += sample.second;
+        ++window.second;
+      }
+
+    for (auto it = windows.rbegin(); it != windows.rend(); ++it)
+      {
+        const double mean = it->second.first / it->second.second;
+        if (std::abs(mean - steady) > tolerance * steady)
+          return (it->first + 1) * windowMs;
+      }
+    return 0;
+  }
+};
+
+/** \brief drives a Forwarder with simulated faces in virtual time
+ *
+ *  The constructor replaces the ndn-cxx clocks with unit test clocks, so
+ *  only one Simulator may exist at a time.
+ */
+class Simulator : noncopyable
+{
+public:
+  explicit
+  Simulator(uint32_t seed = 0)
+    : m_steadyClock(make_shared<ndn::time::UnitTestSteadyClock>())
+    , m_systemClock(make_shared<ndn::time::UnitTestSystemClock>())
+    , m_random(seed)
+    , m_nextUri(1)
+    , m_nextSeq(0)
+    , m_keepSamples(true)
+  {
+    ndn::time::setCustomClocks(m_steadyClock, m_systemClock);
+    m_start = time::steady_clock::now();
+
+    m_downstream = make_shared<SimulatedFace>(ref(*this), "udp4://10.0.0.1:6363",
+                                              UpstreamProfile(), false);
+    m_forwarder.addFace(m_downstream);
+  }
+
+  ~Simulator()
+  {
+    ndn::time::setCustomClocks(nullptr, nullptr);
+  }
+
+  Forwarder&
+  getForwarder()
+  {
+    return m_forwarder;
+  }
+
+  std::mt19937&
+  getRandom()
+  {
+    return m_random;
+  }
+
+  Metrics&
+  getMetrics()
+  {
+    return m_metrics;
+  }
+
+  /** \brief choose \p strategyName for \p prefix
+   */
+  void
+  setStrategy(const Name& prefix, const Name& strategyName)
+  {
+    m_forwarder.getStrategyChoice().insert(prefix, strategyName);
+  }
+
+  /** \brief stop recording per-Interest samples, for long runs where
+   *         only the counters are needed
+   */
+  void
+  setKeepSamples(bool keepSamples)
+  {
+    m_keepSamples = keepSamples;
+  }
+
+  /** \brief add an upstream face with the given profile
+   */
+  shared_ptr<SimulatedFace>
+  addUpstream(const UpstreamProfile& profile)
+  {
+    ++m_nextUri;
+    auto face = make_shared<SimulatedFace>(ref(*this),
+                                           "udp4://10." + std::to_string(m_nextUri / 256 % 256) +
+                                           "." + std::to_string(m_nextUri % 256) + ".1:6363",
+                                           profile, true);
+    m_forwarder.addFace(face);
+    return face;
+  }
+
+  /** \brief add an upstream face serving \p prefix with the given profile
+   */
+  shared_ptr<SimulatedFace>
+  addUpstream(const Name& prefix, const UpstreamProfile& profile)
+  {
+    auto face = addUpstream(profile);
+    addNextHop(prefix, face);
+    return face;
+  }
+
+  void
+  addNextHop(const Name& prefix, const shared_ptr<Face>& face)
+  {
+    m_forwarder.getFib().insert(prefix).first->addNextHop(face, 0);
+  }
+
+  void
+  removePrefix(const Name& prefix)
+  {
+    m_forwarder.getFib().erase(prefix);
+  }
+
+  /** \brief express one Interest under \p prefix from the consumer
+   */
+  void
+  expressInterest(const Name& prefix,
+                  const time::milliseconds& lifetime = time::milliseconds(4000))
+  {
+    Interest interest(Name(prefix).appendNumber(m_nextSeq++));
+    interest.setInterestLifetime(lifetime);
+    interest.setMustBeFresh(true);
+
+    const Name& name = interest.getName();
+    m_pending[name] = time::steady_clock::now();
+    ++m_metrics.nInterests;
+
+    scheduler::schedule(lifetime, [this, name] {
+        auto it = m_pending.find(name);
+        if (it == m_pending.end())
+          return;
+
+        ++m_metrics.nTimeouts;
+        if (m_keepSamples)
+          m_metrics.timeouts.push_back(toMs(it->second - m_start));
+        m_pending.erase(it);
+        m_servedBy.erase(name);
+      });
+
+    m_downstream->receiveInterest(interest);
+  }
+
+  /** \brief advance virtual time by \p duration, expressing \p rate
+   *         Interests per second under \p prefix
+   */
+  void
+  run(const Name& prefix, double rate, const time::nanoseconds& duration,
+      const time::nanoseconds& tick = time::milliseconds(1))
+  {
+    double owed = 0;
+    for (time::nanoseconds elapsed(0); elapsed < duration; elapsed += tick)
+      {
+        owed += rate * time::duration_cast<time::microseconds>(tick).count() / 1e6;
+        for (; owed >= 1; owed -= 1)
+          expressInterest(prefix);
+
+        advance(tick);
+      }
+  }
+
+  /** \brief advance virtual time without generating load
+   */
+  void
+  advance(const time::nanoseconds& tick)
+  {
+    m_steadyClock->advance(tick);
+    m_systemClock->advance(tick);
+
+    boost::asio::io_service& io = getGlobalIoService();
+    if (io.stopped())
+      io.reset();
+    io.poll();
+  }
+
+  double
+  elapsedMs() const
+  {
+    return toMs(time::steady_clock::now() - m_start);
+  }
+
+  static double
+  toMs(const time::nanoseconds& duration)
+  {
+    return time::duration_cast<time::microseconds>(duration).count() / 1000.0;
+  }
+
+public: // called by SimulatedFace
+  void
+  onUpstreamReply(SimulatedFace& face, const Name& name)
+  {
+    auto data = make_shared<Data>(name);
+    data->setFreshnessPeriod(time::seconds(1));
+
+    ndn::SignatureSha256WithRsa fakeSignature;
+    fakeSignature.setValue(ndn::dataBlock(tlv::SignatureValue,
+                                          static_cast<const uint8_t*>(nullptr), 0));
+    data->setSignature(fakeSignature);
+    data->wireEncode();
+
+    if (m_pending.count(name) > 0)
+      m_servedBy[name] = face.getId();
+    face.receiveData(*data);
+  }
+
+  void
+  onConsumerData(const Data& data)
+  {
+    auto it = m_pending.find(data.getName());
+    if (it == m_pending.end())
+      return;
+
+    const double sentMs = toMs(it->second - m_start);
+    const double latencyMs = toMs(time::steady_clock::now() - it->second);
+
+    ++m_metrics.nData;
+    if (m_keepSamples)
+      m_metrics.samples.push_back(std::make_pair(sentMs, latencyMs));
+    ++m_metrics.servedBy[m_servedBy[data.getName()]];
+
+    m_servedBy.erase(data.getName());
+    m_pending.erase(it);
+  }
+
+private:
+  shared_ptr<ndn::time::UnitTestSteadyClock> m_steadyClock;
+  shared_ptr<ndn::time::UnitTestSystemClock> m_systemClock;
+  time::steady_clock::TimePoint m_start;
+
+  Forwarder m_forwarder;
+  shared_ptr<SimulatedFace> m_downstream;
+
+  std::mt19937 m_random;
+  uint64_t m_nextUri;
+  uint64_t m_nextSeq;
+  bool m_keepSamples;
+
+  std::map<Name, time::steady_clock::TimePoint> m_pending;
+  std::map<Name, FaceId> m_servedBy;
+  Metrics m_metrics;
+};
+
+inline
+SimulatedFace::SimulatedFace(Simulator& simulator, const std::string& uri,
+                             const UpstreamProfile& profile_, bool isUpstream)
+  : Face(FaceUri(uri), FaceUri("udp4://10.0.0.254:6363"))
+  , profile(profile_)
+  , nSentInterests(0)
+  , m_simulator(simulator)
+  , m_isUpstream(isUpstream)
+{
+}
+
+inline void
+SimulatedFace::sendInterest(const Interest& interest)
+{
+  ++nSentInterests;
+  if (!m_isUpstream)
+    return;
+
+  std::bernoulli_distribution isLost(profile.loss);
+  if (isLost(m_simulator.getRandom()))
+    return;
+
+  // single-server queue: each reply holds the producer for 1/capacity
+  auto now = time::steady_clock::now();
+  auto departure = std::max(now, m_nextFree);
+  if (profile.capacity > 0)
+    {
+      departure += time::nanoseconds(static_cast<int64_t>(1e9 / profile.capacity));
+      m_nextFree = departure;
+    }
+  departure += profile.delay;
+
+  Name name = interest.getName();
+  scheduler::schedule(departure - now, [this, name] {
+      m_simulator.onUpstreamReply(*this, name);
+    });
+}
+
+inline void
+SimulatedFace::sendData(const Data& data)
+{
+  if (!m_isUpstream)
+    m_simulator.onConsumerData(data);
+}
+
+inline void
+SimulatedFace::close()
+{
+  this->fail("close");
+}
+
+/** \brief flat name -> value metrics printed as a JSON object
+ */
+class Report
+{
+public:
+  void
+  set(const std::string& name, double value)
+  {
+    m_metrics[name] = value;
+  }
+
+  void
+  print(std::ostream& os) const
+  {
+    os << "{\n  \"metrics\": {";
+    bool isFirst = true;
+    for (const auto& metric : m_metrics)
+      {
+        os << (isFirst ? "\n" : ",\n") << "    \"" << metric.first << "\": " << metric.second;
+        isFirst = false;
+      }
+    os << "\n  }\n}\n";
+  }
+
+private:
+  std::map<std::string, double> m_metrics;
+};
+
+} // namespace sim
+} // namespace nfd
+
+#endif // NFD_TESTS_OTHER_STRATEGY_SIMULATOR_HPP
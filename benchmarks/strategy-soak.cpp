@@ -0,0 +1,300 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ *  Soak test: runs one strategy for hours of virtual time under continuous
+ *  churn and watches for resource growth.
+ *
+ *  Prefixes are created and withdrawn every second, upstream faces are
+ *  replaced every 30 seconds and every upstream's delay drifts as a random
+ *  walk.  Once per sampling interval the program records RSS, the live
+ *  strategy info objects, the PIT and Measurements sizes and the CPU time
+ *  per packet.  A series whose least-squares trend over the second half of
+ *  the run (after warm-up) grows by more than the allowed fraction is
+ *  flagged, and the exit status is 1 if any series is flagged.
+ *
+ *  Usage: strategy-soak [weighted|random] [hours] [sample-seconds]
+ */
+
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <unistd.h>
+
+#include "strategy-simulator.hpp"
+
+#include "fw/weighted-load-balancer-strategy.hpp"
+#include "fw/random-load-balancer-strategy.hpp"
+
+namespace nfd {
+namespace sim {
+
+static const size_t N_PREFIXES = 1000;
+static const size_t N_PREFIXES_CHURNED_PER_SECOND = 10;
+static const size_t N_UPSTREAMS = 16;
+static const size_t N_NEXTHOPS_PER_PREFIX = 3;
+static const time::seconds FACE_REPLACEMENT_INTERVAL(30);
+static const double INTEREST_RATE = 200;
+static const double ALLOWED_GROWTH = 0.1;
+
+static double
+getRssBytes()
+{
+  std::ifstream statm("/proc/self/statm");
+  size_t totalPages = 0;
+  size_t residentPages = 0;
+  statm >> totalPages >> residentPages;
+  return static_cast<double>(residentPages) * sysconf(_SC_PAGESIZE);
+}
+
+struct Series
+{
+  std::string name;
+  std::vector<double> values;
+
+  /** \return growth of the least-squares trend over the second half,
+   *          relative to the mean of that half
+   */
+  double
+  growth() const
+  {
+    const size_t begin = values.size() / 2;
+    const size_t n = values.size() - begin;
+    if (n < 2)
+      return 0;
+
+    double sumX = 0, sumY = 0, sumXY = 0, sumXX = 0;
+    for (size_t i = begin; i < values.size(); ++i)
+      {
+        const double x = i - begin;
+        sumX += x;
+        sumY += values[i];
+        sumXY += x * values[i];
+        sumXX += x * x;
+      }
+
+    const double mean = sumY / n;
+    const double slope = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+    return mean > 0 ? slope * (n - 1) / mean : 0;
+  }
+};
+
+class Soak
+{
+public:
+  Soak(const Name& strategyName, uint32_t seed)
+    : m_simulator(seed)
+    , m_random(seed)
+    , m_nextPrefix(0)
+  {
+    m_simulator.setKeepSamples(false);
+    m_simulator.setStrategy("/soak", strategyName);
+
+    for (size_t i = 0; i < N_UPSTREAMS; ++i)
+      m_upstreams.push_back(m_simulator.addUpstream(randomProfile()));
+
+    for (size_t i = 0; i < N_PREFIXES; ++i)
+      addPrefix();
+  }
+
+  void
+  run(const time::seconds& duration, const time::seconds& sampleInterval)
+  {
+    const int64_t nSamples = duration.count() / sampleInterval.count();
+    for (int64_t sample = 0; sample < nSamples; ++sample)
+      {
+        const Metrics before = m_simulator.getMetrics();
+        const std::clock_t cpuBefore = std::clock();
+
+        for (int64_t second = 0; second < sampleInterval.count(); ++second)
+          runOneSecond();
+
+        const Metrics& after = m_simulator.getMetrics();
+        const double nPackets = (after.nInterests - before.nInterests) +
+                                (after.nData - before.nData);
+        const double cpuNs = 1e9 * (std::clock() - cpuBefore) / CLOCKS_PER_SEC;
+
+        Forwarder& forwarder = m_simulator.getForwarder();
+        record("rss_bytes", getRssBytes());
+        record("live_pit_infos", fw::WeightedLoadBalancerStrategy::getNLivePitInfos());
+        record("live_measurement_infos",
+               fw::WeightedLoadBalancerStrategy::getNLiveMeasurementInfos());
+        record("pit_entries", forwarder.getPit().size());
+        record("measurements_entries", forwarder.getMeasurements().size());
+        record("cpu_ns_per_packet", nPackets > 0 ? cpuNs / nPackets : 0);
+      }
+  }
+
+  const std::vector<Series>&
+  getSeries() const
+  {
+    return m_series;
+  }
+
+private:
+  void
+  runOneSecond()
+  {
+    for (size_t i = 0; i < N_PREFIXES_CHURNED_PER_SECOND; ++i)
+      {
+        m_simulator.removePrefix(m_prefixes.front());
+        m_prefixes.pop_front();
+        addPrefix();
+      }
+
+    if (++m_secondsSinceReplacement >= FACE_REPLACEMENT_INTERVAL.count())
+      {
+        m_secondsSinceReplacement = 0;
+        replaceUpstream();
+      }
+
+    std::normal_distribution<double> drift(0, 2);
+    for (const auto& face : m_upstreams)
+      {
+        const double delay = face->profile.delay.count() + drift(m_random);
+        face->profile.delay = time::milliseconds(static_cast<int64_t>(std::min(200.0, std::max(5.0, delay))));
+      }
+
+    std::uniform_int_distribution<size_t> pickPrefix(0, m_prefixes.size() - 1);
+    double owed = 0;
+    for (int tick = 0; tick < 1000; ++tick)
+      {
+        for (owed += INTEREST_RATE / 1000; owed >= 1; owed -= 1)
+          m_simulator.expressInterest(m_prefixes[pickPrefix(m_random)]);
+
+        m_simulator.advance(time::milliseconds(1));
+      }
+  }
+
+  void
+  addPrefix()
+  {
+    Name prefix = Name("/soak").appendNumber(m_nextPrefix++);
+
+    std::vector<shared_ptr<SimulatedFace>> upstreams = m_upstreams;
+    std::shuffle(upstreams.begin(), upstreams.end(), m_random);
+    for (size_t i = 0; i < N_NEXTHOPS_PER_PREFIX; ++i)
+      m_simulator.addNextHop(prefix, upstreams[i]);
+
+    m_prefixes.push_back(prefix);
+  }
+
+  /** \brief close a random upstream and add a fresh one to some prefixes
+   */
+  void
+  replaceUpstream()
+  {
+    std::uniform_int_distribution<size_t> pickFace(0, m_upstreams.size() - 1);
+    const size_t index = pickFace(m_random);
+    m_upstreams[index]->close();
+
+    m_upstreams[index] = m_simulator.addUpstream(randomProfile());
+
+    std::bernoulli_distribution isServed(static_cast<double>(N_NEXTHOPS_PER_PREFIX) / N_UPSTREAMS);
+    for (const Name& prefix : m_prefixes)
+      {
+        if (isServed(m_random))
+          m_simulator.addNextHop(prefix, m_upstreams[index]);
+      }
+  }
+
+  UpstreamProfile
+  randomProfile()
+  {
+    std::uniform_int_distribution<int> delay(5, 100);
+    return UpstreamProfile{time::milliseconds(delay(m_random)), 0, 0.01};
+  }
+
+  void
+  record(const std::string& name, double value)
+  {
+    for (auto& series : m_series)
+      {
+        if (series.name == name)
+          {
+            series.values.push_back(value);
+            return;
+          }
+      }
+    m_series.push_back(Series{name, {value}});
+  }
+
+private:
+  Simulator m_simulator;
+  std::mt19937 m_random;
+
+  std::vector<shared_ptr<SimulatedFace>> m_upstreams;
+  std::deque<Name> m_prefixes;
+  uint64_t m_nextPrefix;
+  int64_t m_secondsSinceReplacement = 0;
+
+  std::vector<Series> m_series;
+};
+
+} // namespace sim
+} // namespace nfd
+
+int
+main(int argc, char** argv)
+{
+  using namespace nfd;
+  using namespace nfd::sim;
+
+  const std::string strategy = argc > 1 ? argv[1] : "weighted";
+  const double hours = argc > 2 ? std::atof(argv[2]) : 2;
+  const int64_t sampleSeconds = argc > 3 ? std::atoll(argv[3]) : 60;
+
+  const Name strategyName = strategy == "random" ?
+                            fw::RandomLoadBalancerStrategy::STRATEGY_NAME :
+                            fw::WeightedLoadBalancerStrategy::STRATEGY_NAME;
+
+  Soak soak(strategyName, 1);
+  soak.run(time::seconds(static_cast<int64_t>(hours * 3600)), time::seconds(sampleSeconds));
+
+  bool isGrowing = false;
+  std::cout << "{\n  \"strategy\": \"" << strategy << "\",\n"
+            << "  \"hours\": " << hours << ",\n"
+            << "  \"sample_seconds\": " << sampleSeconds << ",\n"
+            << "  \"series\": {";
+
+  bool isFirst = true;
+  for (const auto& series : soak.getSeries())
+    {
+      const double growth = series.growth();
+      const bool isFlagged = growth > ALLOWED_GROWTH;
+      isGrowing = isGrowing || isFlagged;
+
+      std::cout << (isFirst ? "\n" : ",\n")
+                << "    \"" << series.name << "\": {\"growth\": " << growth
+                << ", \"flagged\": " << (isFlagged ? "true" : "false") << ", \"values\": [";
+      for (size_t i = 0; i < series.values.size(); ++i)
+        std::cout << (i > 0 ? ", " : "") << series.values[i];
+      std::cout << "]}";
+      isFirst = false;
+    }
+  std::cout << "\n  }\n}\n";
+
+  return isGrowing ? 1 : 0;
+}
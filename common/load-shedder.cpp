@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "load-shedder.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace nfd {
+namespace fw {
+
+static const char* CLASS_NAMES[] = {"bulk", "normal", "critical"};
+
+LoadShedder::LoadShedder()
+  : m_pitLow(0)
+  , m_pitHigh(0)
+  , m_pendingLow(0)
+  , m_pendingHigh(0)
+  , m_nShed()
+{
+}
+
+LoadShedder::LoadShedder(const StrategyParameters& parameters)
+  : m_pitHigh(parameters.getUnsigned("shed-pit-high", 0))
+  , m_pendingHigh(parameters.getUnsigned("shed-pending-high", 0))
+  , m_nShed()
+{
+  m_pitLow = parameters.getUnsigned("shed-pit-low", m_pitHigh * 8 / 10);
+  m_pendingLow = parameters.getUnsigned("shed-pending-low", m_pendingHigh * 8 / 10);
+
+  std::istringstream classes(parameters.get("shed-classes"));
+  for (std::string item; std::getline(classes, item, ','); )
+    {
+      const size_t separator = item.rfind(':');
+      if (separator == std::string::npos)
+        throw StrategyParameters::Error("shed class '" + item + "' is not PREFIX:CLASS");
+
+      const std::string className = item.substr(separator + 1);
+      auto found = std::find(std::begin(CLASS_NAMES), std::end(CLASS_NAMES), className);
+      if (found == std::end(CLASS_NAMES))
+        throw StrategyParameters::Error("unknown shed class '" + className + "'");
+
+      m_classes[Name(item.substr(0, separator))] =
+        static_cast<PriorityClass>(found - std::begin(CLASS_NAMES));
+    }
+}
+
+PriorityClass
+LoadShedder::classify(const Name& name) const
+{
+  if (m_classes.empty())
+    return PRIORITY_NORMAL;
+
+  // longest configured prefix of the name
+  for (size_t length = name.size() + 1; length > 0; --length)
+    {
+      auto it = m_classes.find(name.getPrefix(length - 1));
+      if (it != m_classes.end())
+        return it->second;
+    }
+  return PRIORITY_NORMAL;
+}
+
+void
+LoadShedder::setLimits(const LoadShedder& other)
+{
+  m_pitLow = other.m_pitLow;
+  m_pitHigh = other.m_pitHigh;
+  m_pendingLow = other.m_pendingLow;
+  m_pendingHigh = other.m_pendingHigh;
+  m_classes = other.m_classes;
+}
+
+bool
+LoadShedder::shouldShed(const Name& name, size_t nPitEntries, size_t nPending)
+{
+  if (!isEnabled() || !isAboveLow(nPitEntries, nPending))
+    return false;
+
+  const bool isAboveHigh = isAbove(nPitEntries, m_pitHigh) || isAbove(nPending, m_pendingHigh);
+  const PriorityClass priority = classify(name);
+  const bool isShed = priority == PRIORITY_BULK ||
+                      (priority == PRIORITY_NORMAL && isAboveHigh);
+  if (isShed)
+    ++m_nShed[priority];
+  return isShed;
+}
+
+void
+LoadShedder::writeJson(std::ostream& os, size_t nPitEntries, size_t nPending) const
+{
+  os << "{\"pit_entries\": " << nPitEntries
+     << ", \"pending\": " << nPending
+     << ", \"pit_watermarks\": [" << m_pitLow << ", " << m_pitHigh << "]"
+     << ", \"pending_watermarks\": [" << m_pendingLow << ", " << m_pendingHigh << "]"
+     << ", \"shed\": {";
+  for (int priority = PRIORITY_BULK; priority <= PRIORITY_CRITICAL; ++priority)
+    {
+      os << (priority > PRIORITY_BULK ? ", " : "")
+         << "\"" << CLASS_NAMES[priority] << "\": " << m_nShed[priority];
+    }
+  os << "}}";
+}
+
+} // namespace fw
+} // namespace nfd
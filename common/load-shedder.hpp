@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_LOAD_SHEDDER_HPP
+#define NFD_DAEMON_FW_LOAD_SHEDDER_HPP
+
+#include "strategy-parameters.hpp"
+#include "strategy-info.hpp"
+
+namespace nfd {
+namespace fw {
+
+enum PriorityClass {
+  PRIORITY_BULK = 0,     ///< shed from the low watermark
+  PRIORITY_NORMAL = 1,   ///< shed from the high watermark
+  PRIORITY_CRITICAL = 2  ///< never shed
+};
+
+/** \brief counts one pending Interest of a strategy instance while alive
+ *
+ *  Held by the strategy's PIT entry info, so the count follows the PIT
+ *  however an entry goes away.  The counter is shared so that entries
+ *  outliving the strategy do not touch freed memory.
+ */
+class PendingInterestToken : noncopyable
+{
+public:
+  explicit
+  PendingInterestToken(const shared_ptr<size_t>& counter)
+    : m_counter(counter)
+  {
+    ++*m_counter;
+  }
+
+  ~PendingInterestToken()
+  {
+    --*m_counter;
+  }
+
+private:
+  shared_ptr<size_t> m_counter;
+};
+
+/** \brief decides when Interests for prefixes without a healthy face
+ *         are rejected instead of occupying the PIT for their lifetime
+ *
+ *  Pressure is the larger of the PIT size and the strategy's own pending
+ *  Interests, each relative to its watermarks.  Above the low watermark
+ *  bulk Interests are shed, above the high watermark normal ones too;
+ *  critical Interests are never shed.  The caller only asks when every
+ *  face of the prefix is unhealthy.
+ *
+ *  Parameters: shed-pit-high, shed-pit-low, shed-pending-high,
+ *  shed-pending-low (0 disables a watermark; a low watermark defaults to
+ *  80% of the high one) and shed-classes, a comma separated list of
+ *  PREFIX:CLASS with CLASS bulk, normal or critical.  Names without a
+ *  class are normal.
+ */
+class LoadShedder
+{
+public:
+  /** \brief a shedder that never sheds
+   */
+  LoadShedder();
+
+  /** \throw StrategyParameters::Error a parameter is malformed
+   */
+  explicit
+  LoadShedder(const StrategyParameters& parameters);
+
+  /** \brief take the watermarks and classes of \p other, keeping the
+   *         counters
+   */
+  void
+  setLimits(const LoadShedder& other);
+
+  bool
+  isEnabled() const
+  {
+    return m_pitHigh > 0 || m_pendingHigh > 0;
+  }
+
+  /** \brief whether the PIT or the strategy's pending Interests are
+   *         above their low watermark, where bulk Interests are shed
+   */
+  bool
+  isAboveLow(size_t nPitEntries, size_t nPending) const
+  {
+    return isAbove(nPitEntries, m_pitLow) || isAbove(nPending, m_pendingLow);
+  }
+
+  /** \brief whether an Interest for \p name should be shed
+   *
+   *  Counts the Interest as shed if so.
+   */
+  bool
+  shouldShed(const Name& name, size_t nPitEntries, size_t nPending);
+
+  PriorityClass
+  classify(const Name& name) const;
+
+  void
+  writeJson(std::ostream& os, size_t nPitEntries, size_t nPending) const;
+
+private:
+  static bool
+  isAbove(size_t value, size_t watermark)
+  {
+    return watermark > 0 && value >= watermark;
+  }
+
+private:
+  size_t m_pitLow;
+  size_t m_pitHigh;
+  size_t m_pendingLow;
+  size_t m_pendingHigh;
+  std::map<Name, PriorityClass> m_classes;
+  uint64_t m_nShed[PRIORITY_CRITICAL + 1];
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_LOAD_SHEDDER_HPP
@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "measurement-record.hpp"
+
+namespace nfd {
+namespace fw {
+
+const uint32_t MeasurementRecord::CURRENT_VERSION;
+
+MeasurementRecordStore&
+MeasurementRecordStore::getInstance()
+{
+  static MeasurementRecordStore instance;
+  return instance;
+}
+
+MeasurementRecordStore::MeasurementRecordStore()
+  : m_capacity(65536)
+  , m_maxAge(60)
+  , m_nSaved(0)
+  , m_nTaken(0)
+  , m_nDropped(0)
+{
+}
+
+void
+MeasurementRecordStore::save(MeasurementRecord&& record)
+{
+  auto found = m_index.find(record.prefix);
+  if (found != m_index.end())
+    {
+      m_records.erase(found->second);
+      m_index.erase(found);
+    }
+
+  ++m_nSaved;
+
+  // usually exported just now, so the search stops at once
+  auto position = m_records.end();
+  while (position != m_records.begin() &&
+         record.exportTime < std::prev(position)->exportTime)
+    --position;
+
+  auto inserted = m_records.insert(position, std::move(record));
+  m_index[inserted->prefix] = inserted;
+  evict();
+}
+
+unique_ptr<MeasurementRecord>
+MeasurementRecordStore::take(const Name& prefix)
+{
+  evict();
+
+  auto found = m_index.find(prefix);
+  if (found == m_index.end())
+    return nullptr;
+
+  unique_ptr<MeasurementRecord> record(new MeasurementRecord(std::move(*found->second)));
+  m_records.erase(found->second);
+  m_index.erase(found);
+
+  ++m_nTaken;
+  return record;
+}
+
+void
+MeasurementRecordStore::evict()
+{
+  const auto oldest = time::steady_clock::now() - m_maxAge;
+  while (!m_records.empty() &&
+         (m_records.size() > m_capacity || m_records.front().exportTime < oldest))
+    {
+      m_index.erase(m_records.front().prefix);
+      m_records.pop_front();
+      ++m_nDropped;
+    }
+}
+
+void
+MeasurementRecordStore::writeJson(std::ostream& os) const
+{
+  os << "{\"records\": " << m_records.size()
+     << ", \"saved\": " << m_nSaved
+     << ", \"taken\": " << m_nTaken
+     << ", \"dropped\": " << m_nDropped << "}";
+}
+
+} // namespace fw
+} // namespace nfd
@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_MEASUREMENT_RECORD_HPP
+#define NFD_DAEMON_FW_MEASUREMENT_RECORD_HPP
+
+#include "common.hpp"
+
+#include <list>
+
+namespace nfd {
+namespace fw {
+
+/** \brief what a strategy learnt about the faces of one prefix, in a form
+ *         any strategy can read
+ *
+ *  Delays are plain milliseconds rather than a strategy's own weights, so
+ *  an instance with another mode or version can start from them.  A
+ *  reader must ignore a record whose version it does not know.
+ */
+struct MeasurementRecord
+{
+  static const uint32_t CURRENT_VERSION = 1;
+
+  struct FaceEstimate
+  {
+    FaceId faceId;
+
+    /// last RTT; zero if never measured, max if it timed out since
+    time::milliseconds lastDelay;
+
+    /// smoothed RTT, same conventions
+    time::milliseconds smoothedDelay;
+  };
+
+  uint32_t version = CURRENT_VERSION;
+  Name prefix;
+  time::steady_clock::TimePoint exportTime;
+  std::vector<FaceEstimate> faces;
+};
+
+/** \brief process-wide hand-off of measurement records between strategy
+ *         instances
+ *
+ *  NFD clears the strategy info of a namespace when its strategy
+ *  changes.  The outgoing strategy's info saves a record here when it is
+ *  destroyed, and the incoming strategy takes it when it creates its info
+ *  for the same prefix.  Records older than the maximum age are not
+ *  handed out, and the oldest records are dropped beyond the capacity,
+ *  in case the incoming strategy never creates infos for some prefixes.
+ */
+class MeasurementRecordStore : noncopyable
+{
+public:
+  static MeasurementRecordStore&
+  getInstance();
+
+  /** \brief keep \p record, replacing the one of its prefix
+   *
+   *  Records are kept in the order of their export time, whatever the
+   *  order they are saved in.
+   */
+  void
+  save(MeasurementRecord&& record);
+
+  /** \brief remove and return the record of \p prefix
+   *  \return nullptr if there is none, or it is too old
+   */
+  unique_ptr<MeasurementRecord>
+  take(const Name& prefix);
+
+  void
+  writeJson(std::ostream& os) const;
+
+private:
+  MeasurementRecordStore();
+
+  void
+  evict();
+
+private:
+  /// oldest exportTime first
+  std::list<MeasurementRecord> m_records;
+  std::map<Name, std::list<MeasurementRecord>::iterator> m_index;
+
+  size_t m_capacity;
+  time::seconds m_maxAge;
+
+  uint64_t m_nSaved;
+  uint64_t m_nTaken;
+  uint64_t m_nDropped;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_MEASUREMENT_RECORD_HPP
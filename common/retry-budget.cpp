@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "retry-budget.hpp"
+
+#include <algorithm>
+
+namespace nfd {
+namespace fw {
+
+RetryBudget::RetryBudget(double ratio, const time::seconds& window, double minRetriesPerSecond)
+  : m_ratio(ratio)
+  , m_minRetriesPerSecond(minRetriesPerSecond)
+  , m_slots(std::max<int64_t>(window.count(), 1))
+  , m_current(0)
+  , m_currentStart(time::steady_clock::now())
+  , m_nDeposits(0)
+  , m_nWithdrawals(0)
+  , m_nExhausted(0)
+{
+}
+
+void
+RetryBudget::advance()
+{
+  const auto now = time::steady_clock::now();
+  const int64_t nElapsed =
+    time::duration_cast<time::seconds>(now - m_currentStart).count();
+  if (nElapsed <= 0)
+    return;
+
+  const int64_t nCleared = std::min<int64_t>(nElapsed, m_slots.size());
+  for (int64_t i = 0; i < nCleared; ++i)
+    {
+      m_current = (m_current + 1) % m_slots.size();
+      m_slots[m_current] = Slot();
+    }
+  m_current = (m_current + (nElapsed - nCleared)) % m_slots.size();
+  m_currentStart += time::seconds(nElapsed);
+}
+
+void
+RetryBudget::setLimits(double ratio, const time::seconds& window, double minRetriesPerSecond)
+{
+  advance();
+  m_ratio = ratio;
+  m_minRetriesPerSecond = minRetriesPerSecond;
+
+  const size_t nSlots = std::max<int64_t>(window.count(), 1);
+  if (nSlots == m_slots.size())
+    return;
+
+  // oldest slot first, the current one last
+  std::rotate(m_slots.begin(), m_slots.begin() + m_current + 1, m_slots.end());
+  if (nSlots < m_slots.size())
+    m_slots.erase(m_slots.begin(), m_slots.end() - nSlots);
+  else
+    m_slots.insert(m_slots.begin(), nSlots - m_slots.size(), Slot());
+  m_current = m_slots.size() - 1;
+}
+
+void
+RetryBudget::deposit()
+{
+  advance();
+  ++m_slots[m_current].nDeposits;
+  ++m_nDeposits;
+}
+
+double
+RetryBudget::getBalance()
+{
+  advance();
+
+  uint64_t nDeposits = 0;
+  uint64_t nWithdrawals = 0;
+  for (const auto& slot : m_slots)
+    {
+      nDeposits += slot.nDeposits;
+      nWithdrawals += slot.nWithdrawals;
+    }
+
+  return m_ratio * nDeposits + m_minRetriesPerSecond * m_slots.size() - nWithdrawals;
+}
+
+bool
+RetryBudget::tryWithdraw()
+{
+  if (!isEnabled())
+    {
+      ++m_nWithdrawals;
+      return true;
+    }
+
+  if (getBalance() < 1)
+    {
+      ++m_nExhausted;
+      return false;
+    }
+
+  ++m_slots[m_current].nWithdrawals;
+  ++m_nWithdrawals;
+  return true;
+}
+
+void
+RetryBudget::writeJson(std::ostream& os)
+{
+  os << "{\"ratio\": " << m_ratio
+     << ", \"window_s\": " << m_slots.size()
+     << ", \"min_retries_per_s\": " << m_minRetriesPerSecond
+     << ", \"first_transmissions\": " << m_nDeposits
+     << ", \"retries\": " << m_nWithdrawals
+     << ", \"exhausted\": " << m_nExhausted
+     << ", \"balance\": " << getBalance() << "}";
+}
+
+} // namespace fw
+} // namespace nfd
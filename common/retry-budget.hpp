@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_RETRY_BUDGET_HPP
+#define NFD_DAEMON_FW_RETRY_BUDGET_HPP
+
+#include "common.hpp"
+
+namespace nfd {
+namespace fw {
+
+/** \brief caps retransmissions at a fraction of first transmissions
+ *
+ *  Every first transmission deposits \p ratio tokens and every retry
+ *  withdraws one.  Deposits and withdrawals count over a sliding window
+ *  of one-second slots, so the budget follows the current traffic; a
+ *  small number of retries per second is always allowed so that a
+ *  lightly loaded strategy can still retransmit.  When an upstream slows
+ *  down everywhere at once, retries stop at the budget instead of
+ *  multiplying the load.
+ *
+ *  A ratio of zero turns the budget off: every retry may go ahead, as
+ *  without a budget.
+ */
+class RetryBudget
+{
+public:
+  RetryBudget(double ratio = 0,
+              const time::seconds& window = time::seconds(10),
+              double minRetriesPerSecond = 10);
+
+  /** \brief change the settings, keeping the counters and as much of
+   *         the window as still fits
+   */
+  void
+  setLimits(double ratio, const time::seconds& window, double minRetriesPerSecond);
+
+  bool
+  isEnabled() const
+  {
+    return m_ratio > 0;
+  }
+
+  /** \brief account for a first transmission
+   */
+  void
+  deposit();
+
+  /** \brief take a token for a retry
+   *  \return whether the retry may go ahead, always when the budget is
+   *          off; counts an exhaustion if not
+   */
+  bool
+  tryWithdraw();
+
+  /** \return tokens currently available
+   */
+  double
+  getBalance();
+
+  uint64_t
+  getNExhausted() const
+  {
+    return m_nExhausted;
+  }
+
+  /** \brief write the settings and counters as a JSON object
+   */
+  void
+  writeJson(std::ostream& os);
+
+private:
+  /** \brief move the window to the current time
+   */
+  void
+  advance();
+
+private:
+  struct Slot
+  {
+    uint64_t nDeposits = 0;
+    uint64_t nWithdrawals = 0;
+  };
+
+  double m_ratio;
+  double m_minRetriesPerSecond;
+  std::vector<Slot> m_slots;
+  size_t m_current;
+  time::steady_clock::TimePoint m_currentStart;
+
+  uint64_t m_nDeposits;
+  uint64_t m_nWithdrawals;
+  uint64_t m_nExhausted;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_RETRY_BUDGET_HPP
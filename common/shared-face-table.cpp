@@ -0,0 +1,362 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shared-face-table.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nfd {
+namespace fw {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "shared records need address-free atomics");
+
+/// "NLB" and the layout version
+static const uint32_t TABLE_MAGIC = 0x4e4c4203;
+
+static const size_t MAX_URI = 96;
+static const size_t MAX_PROBES = 32;
+static const int MAX_SPINS = 1000;
+
+static const uint64_t FREE = 0;
+
+/// hash values below this are claim stamps, see getClaimStamp
+static const uint64_t MAX_CLAIM_STAMP = 1ULL << 48;
+
+/// a claim or write older than this was left by a process that died
+static const uint64_t CLAIM_TIMEOUT_MS = 1000;
+
+static const time::seconds MISS_RETRY_INTERVAL(1);
+
+struct SharedFaceTable::Header
+{
+  std::atomic<uint32_t> magic;
+  uint32_t recordSize;
+  char padding[56];
+};
+
+struct SharedFaceTable::Record
+{
+  /// FREE, a claim stamp while the URI is written, then the hash of the URI
+  std::atomic<uint64_t> hash;
+  std::atomic<uint32_t> sequence;
+  std::atomic<uint32_t> nConsecutiveFailures;
+  /// claim stamp of the last writer, stored once it made the sequence odd
+  std::atomic<uint64_t> writeStamp;
+  std::atomic<int64_t> rttUs;
+  char uri[MAX_URI];
+};
+
+shared_ptr<SharedFaceTable>
+SharedFaceTable::open(const std::string& path, FaceTable& faceTable, size_t capacity)
+{
+  static std::map<std::string, weak_ptr<SharedFaceTable>> tables;
+
+  auto table = tables[path].lock();
+  if (table == nullptr)
+    {
+      table.reset(new SharedFaceTable(path, faceTable, capacity));
+      tables[path] = table;
+    }
+  return table;
+}
+
+SharedFaceTable::SharedFaceTable(const std::string& path, FaceTable& faceTable,
+                                 size_t capacity)
+  : m_mapping(MAP_FAILED)
+{
+  m_fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0660);
+  if (m_fd < 0)
+    throw Error("cannot open " + path + ": " + std::strerror(errno));
+
+  // the first process to get here sizes the file and writes the header
+  ::flock(m_fd, LOCK_EX);
+  try
+    {
+      struct stat status;
+      if (::fstat(m_fd, &status) == 0 && status.st_size == 0 &&
+          ::ftruncate(m_fd, sizeof(Header) + capacity * sizeof(Record)) != 0)
+        throw Error("cannot size " + path + ": " + std::strerror(errno));
+
+      ::fstat(m_fd, &status);
+      m_size = status.st_size;
+      if (m_size < sizeof(Header) + sizeof(Record))
+        throw Error(path + " is too small for a shared face table");
+
+      m_mapping = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+      if (m_mapping == MAP_FAILED)
+        throw Error("cannot map " + path + ": " + std::strerror(errno));
+
+      m_header = static_cast<Header*>(m_mapping);
+      if (m_header->magic.load() == 0)
+        {
+          m_header->recordSize = sizeof(Record);
+          m_header->magic.store(TABLE_MAGIC);
+        }
+      if (m_header->magic.load() != TABLE_MAGIC || m_header->recordSize != sizeof(Record))
+        throw Error(path + " is not a shared face table of this version");
+    }
+  catch (const Error&)
+    {
+      if (m_mapping != MAP_FAILED)
+        ::munmap(m_mapping, m_size);
+      ::close(m_fd);
+      throw;
+    }
+  ::flock(m_fd, LOCK_UN);
+
+  m_records = reinterpret_cast<Record*>(static_cast<char*>(m_mapping) + sizeof(Header));
+  m_capacity = (m_size - sizeof(Header)) / sizeof(Record);
+
+  m_afterFaceRemove = faceTable.onRemove.connect(
+    [this] (shared_ptr<Face> face) {
+      m_cache.erase(face->getId());
+    });
+}
+
+SharedFaceTable::~SharedFaceTable()
+{
+  ::munmap(m_mapping, m_size);
+  ::close(m_fd);
+}
+
+static uint64_t
+hashUri(const std::string& uri)
+{
+  // FNV-1a, kept clear of the reserved values
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : uri)
+    {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 1099511628211ULL;
+    }
+  return hash >= MAX_CLAIM_STAMP ? hash : hash + MAX_CLAIM_STAMP;
+}
+
+/** \return the claim stamp for now: milliseconds of the monotonic clock,
+ *          which all processes of the host share, kept clear of FREE
+ *
+ *  ndn-cxx clocks are not used as they can be replaced, see strategy-replay.
+ */
+static uint64_t
+getClaimStamp()
+{
+  using namespace std::chrono;
+  const uint64_t now = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+  return now % (MAX_CLAIM_STAMP - 1) + 1;
+}
+
+SharedFaceTable::Record*
+SharedFaceTable::find(const Face& face)
+{
+  auto cached = m_cache.find(face.getId());
+  if (cached != m_cache.end() && cached->second.record != nullptr)
+    return cached->second.record;
+
+  // only misses look at the clock, hits are the per-packet path
+  const time::steady_clock::TimePoint now = time::steady_clock::now();
+  if (cached != m_cache.end() && now < cached->second.retryTime)
+    return nullptr;
+
+  std::string uri = face.getRemoteUri().toString();
+  uri.resize(std::min(uri.size(), MAX_URI - 1));
+
+  Record* found = probe(uri, hashUri(uri));
+  m_cache[face.getId()] = CacheEntry{found, now + MISS_RETRY_INTERVAL};
+  return found;
+}
+
+SharedFaceTable::Record*
+SharedFaceTable::probe(const std::string& uri, uint64_t hash)
+{
+  for (size_t i = 0; i < std::min(m_capacity, MAX_PROBES); ++i)
+    {
+      Record& record = m_records[(hash + i) % m_capacity];
+      uint64_t current = record.hash.load(std::memory_order_acquire);
+
+      // another process is claiming the record, it may be for this URI
+      for (int spin = 0; current != FREE && current < MAX_CLAIM_STAMP && spin < MAX_SPINS; ++spin)
+        current = record.hash.load(std::memory_order_acquire);
+
+      if (current != FREE && current < MAX_CLAIM_STAMP)
+        {
+          const uint64_t stamp = getClaimStamp();
+          if (stamp >= current && stamp - current < CLAIM_TIMEOUT_MS)
+            return nullptr;
+
+          // the claimer died: take the record over as if it were free
+          if (!record.hash.compare_exchange_strong(current, FREE, std::memory_order_acq_rel))
+            return nullptr;
+          current = FREE;
+        }
+
+      if (current == FREE &&
+          record.hash.compare_exchange_strong(current, getClaimStamp(), std::memory_order_acq_rel))
+        {
+          std::memcpy(record.uri, uri.c_str(), uri.size() + 1);
+          record.hash.store(hash, std::memory_order_release);
+          return &record;
+        }
+
+      // lost the race for a free record: look at what the winner published
+      if (current < MAX_CLAIM_STAMP)
+        return nullptr;
+
+      if (current == hash && uri == record.uri)
+        return &record;
+    }
+
+  return nullptr;
+}
+
+template<typename Update>
+void
+SharedFaceTable::write(const Face& face, const Update& update)
+{
+  Record* record = find(face);
+  if (record == nullptr)
+    return;
+
+  uint32_t sequence = record->sequence.load(std::memory_order_relaxed);
+  bool canBreak = true;
+  for (int spin = 0; ; ++spin)
+    {
+      if (spin == MAX_SPINS)
+        {
+          if (!canBreak || !breakStaleWrite(*record, sequence))
+            return;
+          canBreak = false;
+          spin = 0;
+          sequence = record->sequence.load(std::memory_order_relaxed);
+        }
+
+      if (sequence % 2 == 0 &&
+          record->sequence.compare_exchange_weak(sequence, sequence + 1,
+                                                 std::memory_order_acquire,
+                                                 std::memory_order_relaxed))
+        break;
+      sequence = record->sequence.load(std::memory_order_relaxed);
+    }
+
+  record->writeStamp.store(getClaimStamp(), std::memory_order_relaxed);
+  update(*record);
+
+  // fails only if the write was taken for dead and broken meanwhile
+  ++sequence;
+  record->sequence.compare_exchange_strong(sequence, sequence + 1,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed);
+}
+
+bool
+SharedFaceTable::breakStaleWrite(Record& record, uint32_t sequence)
+{
+  if (sequence % 2 == 0)
+    return false;
+
+  const uint64_t writeStamp = record.writeStamp.load(std::memory_order_relaxed);
+  const uint64_t stamp = getClaimStamp();
+  if (stamp >= writeStamp && stamp - writeStamp < CLAIM_TIMEOUT_MS)
+    return false;
+
+  // the writer died: the fields are atomic one by one, so at worst its
+  // update is half applied
+  return record.sequence.compare_exchange_strong(sequence, sequence + 1,
+                                                 std::memory_order_acq_rel,
+                                                 std::memory_order_relaxed);
+}
+
+void
+SharedFaceTable::recordRtt(const Face& face, const time::microseconds& rtt)
+{
+  write(face, [&rtt] (Record& record) {
+      record.rttUs.store(rtt.count(), std::memory_order_relaxed);
+      record.nConsecutiveFailures.store(0, std::memory_order_relaxed);
+    });
+}
+
+void
+SharedFaceTable::recordFailure(const Face& face)
+{
+  write(face, [] (Record& record) {
+      const uint32_t nFailures = record.nConsecutiveFailures.load(std::memory_order_relaxed);
+      record.nConsecutiveFailures.store(nFailures + 1, std::memory_order_relaxed);
+    });
+}
+
+uint32_t
+SharedFaceTable::getVersion(const Face& face)
+{
+  Record* record = find(face);
+  return record == nullptr ? 0 : record->sequence.load(std::memory_order_acquire);
+}
+
+bool
+SharedFaceTable::read(const Face& face, Snapshot& snapshot)
+{
+  Record* record = find(face);
+  if (record == nullptr)
+    return false;
+
+  uint32_t before = 0;
+  bool canBreak = true;
+  for (int spin = 0; spin < MAX_SPINS; ++spin)
+    {
+      before = record->sequence.load(std::memory_order_acquire);
+      if (before % 2 != 0)
+        {
+          if (spin == MAX_SPINS - 1 && canBreak && breakStaleWrite(*record, before))
+            {
+              canBreak = false;
+              spin = -1;
+            }
+          continue;
+        }
+
+      const int64_t rttUs = record->rttUs.load(std::memory_order_relaxed);
+      const uint32_t nFailures = record->nConsecutiveFailures.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (record->sequence.load(std::memory_order_relaxed) == before)
+        {
+          snapshot.rtt = time::microseconds(rttUs);
+          snapshot.nConsecutiveFailures = nFailures;
+          snapshot.version = before;
+          return true;
+        }
+    }
+  return false;
+}
+
+} // namespace fw
+} // namespace nfd
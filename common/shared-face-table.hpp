@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_SHARED_FACE_TABLE_HPP
+#define NFD_DAEMON_FW_SHARED_FACE_TABLE_HPP
+
+#include "common.hpp"
+#include "face/face.hpp"
+#include "fw/face-table.hpp"
+
+#include <atomic>
+#include <unordered_map>
+
+namespace nfd {
+namespace fw {
+
+/** \brief upstream health and RTT shared by the NFD processes of a host
+ *
+ *  A fixed-size open-addressing table in a memory-mapped file, with one
+ *  record per remote FaceUri.  Every strategy instance of every process
+ *  that opens the same file reads and writes the same records, so a
+ *  timeout seen by one process is visible to the others at once.
+ *
+ *  Records are protected by a seqlock: a writer makes the sequence odd
+ *  with a compare-and-swap, which also excludes other writers, stamps the
+ *  record with the time, and makes the sequence even again when done;
+ *  readers retry until they see the same even sequence before and after
+ *  reading.  A sequence that stays odd with a stamp older than a second
+ *  was left by a process that died in the middle of a write: readers and
+ *  writers make it even again, so at worst that one update is half
+ *  applied.  The URI of a record never changes once its hash is published.
+ *
+ *  A free record is claimed by stamping it with the claim time while its
+ *  URI is written.  Other processes wait for the claim to be published,
+ *  and take the record over when the stamp is older than a second, so a
+ *  process that died while claiming does not leave it unusable.
+ */
+class SharedFaceTable : noncopyable
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  struct Snapshot
+  {
+    /// RTT of the last Data, zero if none
+    time::microseconds rtt;
+
+    /// timeouts since the last Data
+    uint32_t nConsecutiveFailures;
+
+    /// even sequence of the record; changes with every write
+    uint32_t version;
+  };
+
+  /** \brief map the table at \p path, creating it with room for
+   *         \p capacity records if it does not exist
+   *
+   *  Instances of one process opening the same path share the mapping.
+   *  Faces removed from \p faceTable are dropped from the lookup cache.
+   *  \throw Error the file cannot be created or mapped, or holds
+   *               something else
+   */
+  static shared_ptr<SharedFaceTable>
+  open(const std::string& path, FaceTable& faceTable, size_t capacity = 4096);
+
+  ~SharedFaceTable();
+
+  /** \brief a Data came back from \p face after \p rtt
+   */
+  void
+  recordRtt(const Face& face, const time::microseconds& rtt);
+
+  /** \brief an Interest sent to \p face timed out
+   */
+  void
+  recordFailure(const Face& face);
+
+  /** \return current version of the record of \p face, 0 if it has none;
+   *          cheap enough to poll for every Interest
+   */
+  uint32_t
+  getVersion(const Face& face);
+
+  /** \return whether \p face has a record that could be read
+   */
+  bool
+  read(const Face& face, Snapshot& snapshot);
+
+private:
+  struct Record;
+  struct Header;
+
+  struct CacheEntry
+  {
+    Record* record;
+
+    /// when a miss is looked up again
+    time::steady_clock::TimePoint retryTime;
+  };
+
+  SharedFaceTable(const std::string& path, FaceTable& faceTable, size_t capacity);
+
+  /** \return the record for \p face, claiming a free one if it has none,
+   *          or nullptr if the table is full around its slot or another
+   *          process is still claiming it
+   *
+   *  Records found are cached by FaceId until the face is removed, so
+   *  the clock is read only for misses, which are looked up again after
+   *  a second as the table may have changed by then.
+   */
+  Record*
+  find(const Face& face);
+
+  Record*
+  probe(const std::string& uri, uint64_t hash);
+
+  template<typename Update>
+  void
+  write(const Face& face, const Update& update);
+
+  /** \brief make the odd \p sequence of \p record even if its writer
+   *         stamped it more than a second ago
+   *  \return whether the sequence was made even
+   */
+  static bool
+  breakStaleWrite(Record& record, uint32_t sequence);
+
+private:
+  int m_fd;
+  void* m_mapping;
+  size_t m_size;
+  Header* m_header;
+  Record* m_records;
+  size_t m_capacity;
+  std::unordered_map<FaceId, CacheEntry> m_cache;
+  signal::ScopedConnection m_afterFaceRemove;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_SHARED_FACE_TABLE_HPP
@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "strategy-config.hpp"
+#include "strategy-control.hpp"
+
+#include "core/config-file.hpp"
+#include "core/logger.hpp"
+
+#include <boost/property_tree/info_parser.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+NFD_LOG_INIT("StrategyConfig");
+
+namespace nfd {
+namespace fw {
+
+const std::string StrategyConfig::SECTION_NAME = "strategy_defaults";
+const std::string StrategyConfig::RELOAD_COMMAND = "reload-defaults";
+
+static shared_ptr<const StrategyConfig>&
+getCurrentConfig()
+{
+  static shared_ptr<const StrategyConfig> config;
+  return config;
+}
+
+/** \return the argument of NFD's --config or -c option, empty if none
+ *
+ *  Read from /proc, since the strategies have no access to argv.
+ */
+static std::string
+findCommandLineConfigFile()
+{
+  std::ifstream is("/proc/self/cmdline");
+  const std::string cmdline((std::istreambuf_iterator<char>(is)),
+                            std::istreambuf_iterator<char>());
+
+  std::vector<std::string> arguments;
+  for (size_t start = 0, end; start < cmdline.size(); start = end + 1)
+    {
+      end = cmdline.find('\0', start);
+      if (end == std::string::npos)
+        end = cmdline.size();
+      arguments.push_back(cmdline.substr(start, end - start));
+    }
+
+  static const std::string OPTION = "--config";
+  for (size_t i = 1; i < arguments.size(); ++i)
+    {
+      if ((arguments[i] == OPTION || arguments[i] == "-c") && i + 1 < arguments.size())
+        return arguments[i + 1];
+      if (arguments[i].compare(0, OPTION.size() + 1, OPTION + "=") == 0)
+        return arguments[i].substr(OPTION.size() + 1);
+    }
+  return "";
+}
+
+/** \brief read the section from the configuration file, before NFD does
+ */
+static shared_ptr<const StrategyConfig>
+loadConfigFile()
+{
+  std::string path;
+  const char* fromEnvironment = std::getenv("NFD_STRATEGY_CONFIG_FILE");
+  if (fromEnvironment != nullptr)
+    path = fromEnvironment;
+  if (path.empty())
+    path = findCommandLineConfigFile();
+#ifdef DEFAULT_CONFIG_FILE
+  if (path.empty())
+    path = DEFAULT_CONFIG_FILE;
+#endif
+
+  std::ifstream is;
+  if (!path.empty())
+    is.open(path);
+  if (!is)
+    return make_shared<StrategyConfig>();
+
+  try
+    {
+      boost::property_tree::ptree tree;
+      boost::property_tree::read_info(is, tree);
+
+      auto section = tree.get_child_optional(StrategyConfig::SECTION_NAME);
+      if (!section)
+        return make_shared<StrategyConfig>();
+
+      NFD_LOG_INFO("strategy defaults from " << path);
+      return make_shared<StrategyConfig>(*section);
+    }
+  catch (const std::exception& e)
+    {
+      // NFD reports the error when it parses the file itself
+      NFD_LOG_WARN("ignoring strategy defaults in " << path << ": " << e.what());
+      return make_shared<StrategyConfig>();
+    }
+}
+
+StrategyConfig::StrategyConfig()
+{
+}
+
+StrategyConfig::StrategyConfig(const boost::property_tree::ptree& section)
+{
+  for (const auto& item : section)
+    {
+      if (item.second.empty())
+        {
+          m_values[""][item.first] = item.second.data();
+          continue;
+        }
+
+      if (!item.second.data().empty())
+        throw Error(SECTION_NAME + "." + item.first + " has both a value and keys");
+
+      for (const auto& parameter : item.second)
+        {
+          if (!parameter.second.empty())
+            throw Error(SECTION_NAME + "." + item.first + "." + parameter.first +
+                        " is not a key and value");
+          m_values[item.first][parameter.first] = parameter.second.data();
+        }
+    }
+}
+
+bool
+StrategyConfig::find(const std::string& label, const std::string& key, std::string& value) const
+{
+  for (const std::string& scope : {label, std::string()})
+    {
+      auto values = m_values.find(scope);
+      if (values == m_values.end())
+        continue;
+
+      auto found = values->second.find(key);
+      if (found != values->second.end())
+        {
+          value = found->second;
+          return true;
+        }
+    }
+  return false;
+}
+
+shared_ptr<const StrategyConfig>
+StrategyConfig::getCurrent()
+{
+  shared_ptr<const StrategyConfig>& config = getCurrentConfig();
+  if (config == nullptr)
+    config = loadConfigFile();
+  return config;
+}
+
+void
+StrategyConfig::addSectionHandler(ConfigFile& config)
+{
+  config.addSectionHandler(SECTION_NAME,
+    [] (const ConfigSection& section, bool isDryRun, const std::string& filename) {
+      shared_ptr<const StrategyConfig> parsed;
+      try
+        {
+          parsed = make_shared<StrategyConfig>(section);
+        }
+      catch (const Error& e)
+        {
+          throw ConfigFile::Error("in " + filename + ": " + e.what());
+        }
+
+      if (isDryRun)
+        return;
+
+      // the instances running already take it too, all of them or none
+      shared_ptr<const StrategyConfig> previous = getCurrent();
+      getCurrentConfig() = parsed;
+
+      std::string reply;
+      if (!StrategyControl::getInstance().executeChecked(RELOAD_COMMAND, {},
+                                                         [&reply] (const std::string& r) {
+                                                           reply = r;
+                                                         }))
+        {
+          getCurrentConfig() = previous;
+          throw ConfigFile::Error("in " + filename + ", " + SECTION_NAME +
+                                  " refused by the running strategies: " + reply);
+        }
+
+      NFD_LOG_INFO("strategy defaults from " << filename << " applied: " << reply);
+    });
+}
+
+} // namespace fw
+} // namespace nfd
@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_STRATEGY_CONFIG_HPP
+#define NFD_DAEMON_FW_STRATEGY_CONFIG_HPP
+
+#include "common.hpp"
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace nfd {
+
+class ConfigFile;
+
+namespace fw {
+
+/** \brief strategy parameter defaults from the strategy_defaults section
+ *         of nfd.conf
+ *
+ *  Keys are parameter names as in strategy names.  Keys directly in the
+ *  section apply to every strategy; keys in a subsection named after a
+ *  strategy, e.g. weighted-load-balancer, apply to it only and take
+ *  precedence.  A parameter in the strategy's name or in the environment
+ *  overrides both, see StrategyParameters.
+ *
+ *  NFD creates its strategy instances before it reads its configuration,
+ *  so the section is first read straight from the file, which is
+ *  NFD_STRATEGY_CONFIG_FILE, else the file given to NFD with --config,
+ *  else NFD's default configuration file.  Once addSectionHandler() is
+ *  installed, NFD's own parse of the file and of every reload replaces
+ *  it: the running instances apply the parameters they can change live
+ *  (RELOAD_COMMAND), and instances created later start from it.  A
+ *  configuration never changes after it is parsed.
+ */
+class StrategyConfig : noncopyable
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  static const std::string SECTION_NAME;
+
+  /** \brief checked StrategyControl command with which a strategy
+   *         instance applies the current configuration
+   */
+  static const std::string RELOAD_COMMAND;
+
+  /** \brief an empty configuration
+   */
+  StrategyConfig();
+
+  /** \throw Error the section is nested deeper than strategy subsections
+   */
+  explicit
+  StrategyConfig(const boost::property_tree::ptree& section);
+
+  /** \brief look up \p key for the strategy named \p label
+   */
+  bool
+  find(const std::string& label, const std::string& key, std::string& value) const;
+
+  /** \return the configuration new instances start with
+   */
+  static shared_ptr<const StrategyConfig>
+  getCurrent();
+
+  /** \brief have NFD parse the section of its configuration file
+   *
+   *  NFD rejects sections nobody handles, so its configuration can only
+   *  hold the section once this is called, from Nfd::initialize() before
+   *  the file is parsed (see README.md).  A section some running instance
+   *  refuses is an error, and leaves every instance as it was.
+   */
+  static void
+  addSectionHandler(ConfigFile& config);
+
+private:
+  /// keys of every strategy under "", those of one strategy under its label
+  std::map<std::string, std::map<std::string, std::string>> m_values;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_STRATEGY_CONFIG_HPP
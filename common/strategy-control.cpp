@@ -0,0 +1,533 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "strategy-control.hpp"
+
+#include "core/global-io.hpp"
+#include "core/logger.hpp"
+#include "core/scheduler.hpp"
+
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <set>
+#include <sstream>
+
+#include <grp.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+NFD_LOG_INIT("StrategyControl");
+
+namespace nfd {
+namespace fw {
+
+using boost::asio::local::stream_protocol;
+
+/// longest request line; a client sending more gets an error
+static const size_t MAX_REQUEST_SIZE = 4096;
+
+/// a client must send its request and take its reply within this
+static const time::seconds CONNECTION_TIMEOUT(10);
+
+StrategyControl&
+StrategyControl::getInstance()
+{
+  static StrategyControl instance;
+  return instance;
+}
+
+StrategyControl::StrategyControl()
+{
+  // constructed before this object, so it outlives the acceptor
+  getGlobalIoService();
+}
+
+StrategyControl::~StrategyControl()
+{
+  if (m_acceptor != nullptr)
+    {
+      m_acceptor.reset();
+      ::unlink(m_path.c_str());
+    }
+}
+
+void
+StrategyControl::listen(const std::string& path, const std::string& group)
+{
+  if (m_acceptor != nullptr)
+    {
+      if (path != m_path)
+        NFD_LOG_WARN("control socket already at " << m_path << ", ignoring " << path);
+      return;
+    }
+
+  // a socket left behind by a previous run
+  ::unlink(path.c_str());
+
+  try
+    {
+      m_acceptor.reset(new stream_protocol::acceptor(getGlobalIoService(),
+                                                     stream_protocol::endpoint(path)));
+    }
+  catch (const boost::system::system_error& e)
+    {
+      throw Error("cannot listen on " + path + ": " + e.what());
+    }
+
+  try
+    {
+      setPermissions(path, group);
+    }
+  catch (const Error&)
+    {
+      m_acceptor.reset();
+      ::unlink(path.c_str());
+      throw;
+    }
+
+  m_path = path;
+  NFD_LOG_INFO("control socket at " << m_path);
+  acceptConnection();
+}
+
+void
+StrategyControl::setPermissions(const std::string& path, const std::string& group)
+{
+  mode_t mode = S_IRUSR | S_IWUSR;
+  if (!group.empty())
+    {
+      const struct group* entry = ::getgrnam(group.c_str());
+      if (entry == nullptr)
+        throw Error("unknown group " + group + " for " + path);
+      if (::chown(path.c_str(), static_cast<uid_t>(-1), entry->gr_gid) != 0)
+        throw Error("cannot give " + path + " to group " + group + ": " + std::strerror(errno));
+      mode |= S_IRGRP | S_IWGRP;
+    }
+
+  if (::chmod(path.c_str(), mode) != 0)
+    throw Error("cannot restrict access to " + path + ": " + std::strerror(errno));
+}
+
+void
+StrategyControl::setHandler(const Name& strategyName, const std::string& command,
+                            const Handler& handler)
+{
+  setAsyncHandler(strategyName, command,
+                  [handler] (const std::vector<std::string>& arguments, const ReplyCallback& done) {
+                    std::ostringstream reply;
+                    handler(arguments, reply);
+                    done(reply.str());
+                  });
+}
+
+void
+StrategyControl::setAsyncHandler(const Name& strategyName, const std::string& command,
+                                 const AsyncHandler& handler)
+{
+  m_handlers[strategyName][command] = handler;
+}
+
+void
+StrategyControl::setCheckedHandler(const Name& strategyName, const std::string& command,
+                                   const CheckedHandler& handler)
+{
+  m_checkedHandlers[strategyName][command] = handler;
+}
+
+void
+StrategyControl::removeHandlers(const Name& strategyName)
+{
+  m_handlers.erase(strategyName);
+  m_checkedHandlers.erase(strategyName);
+}
+
+namespace {
+
+/** \brief replies of one request, until the last strategy has answered
+ */
+struct PendingReply
+{
+  std::vector<Name> strategyNames;
+  std::vector<std::string> replies;
+  std::vector<bool> isAnswered;
+  size_t nUnanswered;
+  StrategyControl::ReplyCallback done;
+};
+
+void
+answer(const shared_ptr<PendingReply>& pending, size_t index, const std::string& reply)
+{
+  if (pending->isAnswered[index])
+    return;
+
+  pending->replies[index] = reply;
+  pending->isAnswered[index] = true;
+  if (--pending->nUnanswered > 0)
+    return;
+
+  std::ostringstream os;
+  os << "{";
+  for (size_t i = 0; i < pending->replies.size(); ++i)
+    {
+      os << (i > 0 ? ",\n" : "\n");
+      writeJsonString(os, pending->strategyNames[i].toUri());
+      os << ": " << pending->replies[i];
+    }
+  os << "\n}\n";
+  pending->done(os.str());
+}
+
+void
+replyError(const StrategyControl::ReplyCallback& done, const std::string& message)
+{
+  std::ostringstream reply;
+  reply << "{\n\"error\": ";
+  writeJsonString(reply, message);
+  reply << "\n}\n";
+  done(reply.str());
+}
+
+template<typename Handlers>
+bool
+hasHandler(const Handlers& handlers, const Name& strategyName, const std::string& command)
+{
+  auto strategy = handlers.find(strategyName);
+  return strategy != handlers.end() && strategy->second.count(command) > 0;
+}
+
+} // namespace
+
+std::vector<Name>
+StrategyControl::selectTargets(const Name& target, const std::string& command) const
+{
+  std::set<Name> handling;
+  for (const auto& strategy : m_handlers)
+    {
+      if (strategy.second.count(command) > 0)
+        handling.insert(strategy.first);
+    }
+  for (const auto& strategy : m_checkedHandlers)
+    {
+      if (strategy.second.count(command) > 0)
+        handling.insert(strategy.first);
+    }
+
+  // an instance name is also the prefix of instances with more parameters
+  if (handling.count(target) > 0)
+    return {target};
+
+  std::vector<Name> targets;
+  for (const auto& name : handling)
+    {
+      if (target.isPrefixOf(name))
+        targets.push_back(name);
+    }
+  return targets;
+}
+
+void
+StrategyControl::execute(const std::string& request, const ReplyCallback& done) const
+{
+  std::istringstream is(request);
+  std::string command;
+  is >> command;
+
+  std::vector<std::string> arguments;
+  for (std::string argument; is >> argument; )
+    arguments.push_back(argument);
+
+  Name target;
+  if (!arguments.empty() && arguments.front().size() > 1 && arguments.front()[0] == '@')
+    {
+      try
+        {
+          target = Name(arguments.front().substr(1));
+        }
+      catch (const std::exception& e)
+        {
+          replyError(done, "invalid target '" + arguments.front() + "': " + e.what());
+          return;
+        }
+      arguments.erase(arguments.begin());
+    }
+
+  const std::vector<Name> targets = selectTargets(target, command);
+  if (targets.empty())
+    {
+      replyError(done, "no strategy " + (target.empty() ? "" : "under " + target.toUri() + " ") +
+                       "handles '" + command + "'");
+      return;
+    }
+
+  if (hasHandler(m_checkedHandlers, targets.front(), command))
+    {
+      executeChecked(targets, command, arguments, done);
+      return;
+    }
+
+  // handlers may finish later, when m_handlers could have changed
+  std::vector<AsyncHandler> handlers;
+  auto pending = make_shared<PendingReply>();
+  for (const auto& name : targets)
+    {
+      if (!hasHandler(m_handlers, name, command))
+        continue;
+
+      pending->strategyNames.push_back(name);
+      handlers.push_back(m_handlers.find(name)->second.find(command)->second);
+    }
+
+  pending->replies.resize(handlers.size());
+  pending->isAnswered.resize(handlers.size(), false);
+  pending->nUnanswered = handlers.size();
+  pending->done = done;
+
+  for (size_t i = 0; i < handlers.size(); ++i)
+    {
+      try
+        {
+          handlers[i](arguments,
+                      [pending, i] (const std::string& reply) { answer(pending, i, reply); });
+        }
+      catch (const std::exception& e)
+        {
+          std::ostringstream reply;
+          reply << "{\"error\": ";
+          writeJsonString(reply, e.what());
+          reply << "}";
+          answer(pending, i, reply.str());
+        }
+    }
+}
+
+bool
+StrategyControl::executeChecked(const std::string& command,
+                                const std::vector<std::string>& arguments,
+                                const ReplyCallback& done) const
+{
+  const std::vector<Name> targets = selectTargets(Name(), command);
+  if (targets.empty())
+    {
+      done("{}\n");
+      return true;
+    }
+  return executeChecked(targets, command, arguments, done);
+}
+
+bool
+StrategyControl::executeChecked(const std::vector<Name>& targets, const std::string& command,
+                                const std::vector<std::string>& arguments,
+                                const ReplyCallback& done) const
+{
+  std::vector<Action> actions(targets.size());
+  std::vector<std::vector<std::string>> accepted(targets.size());
+  std::vector<std::string> errors(targets.size());
+  bool isRefused = false;
+  std::set<std::string> unaccepted(arguments.begin(), arguments.end());
+
+  for (size_t i = 0; i < targets.size(); ++i)
+    {
+      if (!hasHandler(m_checkedHandlers, targets[i], command))
+        {
+          errors[i] = "'" + command + "' cannot be checked before it takes effect";
+          isRefused = true;
+          continue;
+        }
+
+      try
+        {
+          actions[i] = m_checkedHandlers.find(targets[i])->second.find(command)->second(
+                         arguments, accepted[i]);
+          for (const auto& argument : accepted[i])
+            unaccepted.erase(argument);
+        }
+      catch (const std::exception& e)
+        {
+          errors[i] = e.what();
+          isRefused = true;
+        }
+    }
+
+  std::ostringstream reply;
+  reply << "{";
+  if (isRefused || !unaccepted.empty())
+    {
+      reply << "\n\"error\": ";
+      writeJsonString(reply, isRefused ? "refused by an instance, nothing changed" :
+                             "no instance takes '" + *unaccepted.begin() + "', nothing changed");
+    }
+
+  for (size_t i = 0; i < targets.size(); ++i)
+    {
+      reply << (i > 0 || isRefused || !unaccepted.empty() ? ",\n" : "\n");
+      writeJsonString(reply, targets[i].toUri());
+      reply << ": ";
+      if (!errors[i].empty())
+        {
+          reply << "{\"error\": ";
+          writeJsonString(reply, errors[i]);
+          reply << "}";
+        }
+      else if (isRefused || !unaccepted.empty() || accepted[i].empty())
+        {
+          reply << "{\"changed\": false}";
+        }
+      else
+        {
+          actions[i](reply);
+        }
+    }
+  reply << "\n}\n";
+  done(reply.str());
+  return !isRefused && unaccepted.empty();
+}
+
+namespace {
+
+/** \brief one client connection, kept alive by its pending handlers
+ */
+struct Connection
+{
+  explicit
+  Connection(boost::asio::io_service& io)
+    : socket(io)
+    , request(MAX_REQUEST_SIZE)
+  {
+  }
+
+  ~Connection()
+  {
+    scheduler::cancel(timeout);
+  }
+
+  void
+  close()
+  {
+    boost::system::error_code error;
+    socket.close(error);
+  }
+
+  /** \brief send \p reply, then close
+   */
+  void
+  send(const shared_ptr<Connection>& self, const std::string& reply)
+  {
+    this->reply = reply;
+    boost::asio::async_write(socket, boost::asio::buffer(this->reply),
+      [self] (const boost::system::error_code&, size_t) {
+        self->close();
+      });
+  }
+
+  stream_protocol::socket socket;
+  boost::asio::streambuf request;
+  std::string reply;
+  scheduler::EventId timeout;
+};
+
+} // namespace
+
+void
+StrategyControl::acceptConnection()
+{
+  auto connection = make_shared<Connection>(ref(getGlobalIoService()));
+  m_acceptor->async_accept(connection->socket,
+    [this, connection] (const boost::system::error_code& error) {
+      if (error == boost::asio::error::operation_aborted)
+        return;
+
+      if (!error)
+        {
+          // a stalled client is dropped, with whatever it is waiting for
+          weak_ptr<Connection> weakConnection = connection;
+          connection->timeout = scheduler::schedule(CONNECTION_TIMEOUT, [weakConnection] {
+              auto connection = weakConnection.lock();
+              if (connection != nullptr)
+                connection->close();
+            });
+
+          boost::asio::async_read_until(connection->socket, connection->request, '\n',
+            [this, connection] (const boost::system::error_code& error, size_t) {
+              if (error == boost::asio::error::not_found)
+                {
+                  std::ostringstream reply;
+                  reply << "{\n\"error\": ";
+                  writeJsonString(reply, "request longer than " +
+                                         std::to_string(MAX_REQUEST_SIZE) + " bytes");
+                  reply << "\n}\n";
+                  connection->send(connection, reply.str());
+                  return;
+                }
+              if (error)
+                return;
+
+              std::istream is(&connection->request);
+              std::string line;
+              std::getline(is, line);
+              execute(line, [connection] (const std::string& reply) {
+                  connection->send(connection, reply);
+                });
+            });
+        }
+
+      acceptConnection();
+    });
+}
+
+void
+writeJsonString(std::ostream& os, const std::string& value)
+{
+  os << '"';
+  for (char c : value)
+    {
+      switch (c)
+        {
+        case '"':
+          os << "\\\"";
+          break;
+        case '\\':
+          os << "\\\\";
+          break;
+        case '\n':
+          os << "\\n";
+          break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20)
+            os << "\\u00" << std::hex << std::setw(2) << std::setfill('0')
+               << static_cast<int>(c) << std::dec;
+          else
+            os << c;
+        }
+    }
+  os << '"';
+}
+
+} // namespace fw
+} // namespace nfd
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_STRATEGY_CONTROL_HPP
+#define NFD_DAEMON_FW_STRATEGY_CONTROL_HPP
+
+#include "common.hpp"
+
+#include <boost/asio/local/stream_protocol.hpp>
+
+namespace nfd {
+namespace fw {
+
+/** \brief process-wide control socket of the strategies
+ *
+ *  A client connects to the Unix stream socket, sends one line
+ *  "COMMAND [@TARGET] [ARGUMENT...]" and receives a JSON object holding
+ *  the reply of every targeted strategy instance that handles COMMAND,
+ *  keyed by strategy name, after which the server closes the connection.
+ *  TARGET is the name of an instance, or a prefix of the names of the
+ *  instances to target, e.g. /localhost/nfd/strategy/weighted-load-balancer;
+ *  without it every instance is targeted.  tools/strategy-ctl.py is the
+ *  client.
+ *
+ *  A command registered as a CheckedHandler takes effect on every
+ *  targeted instance or on none: all instances check the arguments
+ *  first, and nothing is applied if one refuses them or if an argument
+ *  is taken by none of them.
+ *
+ *  The socket is served on the global io_service, so handlers run on the
+ *  forwarding thread and can read strategy state without locking.  A
+ *  handler that would hold up forwarding for long registers as an
+ *  AsyncHandler and answers over several event loop iterations.
+ */
+class StrategyControl : noncopyable
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  /** \brief writes the reply to \p arguments as a JSON value
+   */
+  typedef std::function<void(const std::vector<std::string>& arguments,
+                             std::ostream& reply)> Handler;
+
+  /** \brief receives a complete JSON reply
+   */
+  typedef std::function<void(const std::string& reply)> ReplyCallback;
+
+  /** \brief passes the reply to \p arguments to \p done once, possibly from
+   *         a later event loop iteration
+   *
+   *  An exception thrown before \p done is called becomes the reply.
+   */
+  typedef std::function<void(const std::vector<std::string>& arguments,
+                             const ReplyCallback& done)> AsyncHandler;
+
+  /** \brief applies checked arguments and writes the reply as a JSON value;
+   *         must not throw
+   */
+  typedef std::function<void(std::ostream& reply)> Action;
+
+  /** \brief checks \p arguments without changing anything, and returns
+   *         the Action applying them
+   *  \param[out] accepted the arguments the instance takes; it ignores
+   *              the others
+   *  \throw std::exception an accepted argument is invalid
+   */
+  typedef std::function<Action(const std::vector<std::string>& arguments,
+                               std::vector<std::string>& accepted)> CheckedHandler;
+
+  static StrategyControl&
+  getInstance();
+
+  ~StrategyControl();
+
+  /** \brief start serving on \p path, unless already serving there
+   *
+   *  The socket is accessible to the owner only, or also to the members of
+   *  \p group if it is not empty, since its commands retune forwarding.
+   *  \throw Error the socket cannot be created, or \p group is unknown
+   */
+  void
+  listen(const std::string& path, const std::string& group = "");
+
+  void
+  setHandler(const Name& strategyName, const std::string& command, const Handler& handler);
+
+  void
+  setAsyncHandler(const Name& strategyName, const std::string& command,
+                  const AsyncHandler& handler);
+
+  void
+  setCheckedHandler(const Name& strategyName, const std::string& command,
+                    const CheckedHandler& handler);
+
+  void
+  removeHandlers(const Name& strategyName);
+
+  /** \brief execute a request line as if it came from the socket
+   *  \param done receives the JSON reply once every strategy has answered
+   */
+  void
+  execute(const std::string& request, const ReplyCallback& done) const;
+
+  /** \brief execute the checked \p command on every instance handling it
+   *  \param done receives the JSON reply, before this returns
+   *  \return whether it took effect, which it does on every instance or
+   *          none; true if no instance handles it
+   */
+  bool
+  executeChecked(const std::string& command, const std::vector<std::string>& arguments,
+                 const ReplyCallback& done) const;
+
+private:
+  StrategyControl();
+
+  /** \return the instances handling \p command that \p target selects:
+   *          the instance named \p target if there is one, otherwise
+   *          every instance under \p target
+   */
+  std::vector<Name>
+  selectTargets(const Name& target, const std::string& command) const;
+
+  bool
+  executeChecked(const std::vector<Name>& targets, const std::string& command,
+                 const std::vector<std::string>& arguments, const ReplyCallback& done) const;
+
+  void
+  acceptConnection();
+
+  /** \brief restrict access to the socket at \p path
+   *  \throw Error
+   */
+  static void
+  setPermissions(const std::string& path, const std::string& group);
+
+private:
+  std::map<Name, std::map<std::string, AsyncHandler>> m_handlers;
+  std::map<Name, std::map<std::string, CheckedHandler>> m_checkedHandlers;
+  unique_ptr<boost::asio::local::stream_protocol::acceptor> m_acceptor;
+  std::string m_path;
+};
+
+/** \brief write \p value as a JSON string
+ */
+void
+writeJsonString(std::ostream& os, const std::string& value);
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_STRATEGY_CONTROL_HPP
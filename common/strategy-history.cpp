@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "strategy-history.hpp"
+#include "strategy-recorder.hpp"
+#include "strategy-control.hpp"
+
+#include <fstream>
+
+namespace nfd {
+namespace fw {
+
+const size_t StrategyHistory::MAX_FACES_PER_SAMPLE = 32;
+
+static const uint32_t MAX_IDLE_SECONDS = 60;
+
+StrategyHistory::StrategyHistory(const time::seconds& length)
+  : m_length(std::max<int64_t>(length.count(), 1))
+  , m_next(0)
+{
+  m_sampling = scheduler::schedule(time::seconds(1), bind(&StrategyHistory::takeSample, this));
+}
+
+StrategyHistory::~StrategyHistory()
+{
+  scheduler::cancel(m_sampling);
+}
+
+shared_ptr<StrategyHistory::FaceCounters>
+StrategyHistory::getCounters(FaceId faceId)
+{
+  shared_ptr<FaceCounters>& counters = m_faces[faceId];
+  if (counters == nullptr)
+    counters = make_shared<FaceCounters>();
+  return counters;
+}
+
+void
+StrategyHistory::countData(FaceCounters& counters, const time::nanoseconds& rtt)
+{
+  ++counters.nData;
+
+  const double rttUs = rtt.count() / 1000.0;
+  if (counters.srttUs == 0)
+    counters.srttUs = rttUs;
+  else
+    counters.srttUs += (rttUs - counters.srttUs) / 8;
+}
+
+void
+StrategyHistory::takeSample()
+{
+  m_sampling = scheduler::schedule(time::seconds(1), bind(&StrategyHistory::takeSample, this));
+
+  if (m_samples.size() < m_length)
+    m_samples.emplace_back();
+  Sample& sample = m_samples[m_next];
+  m_next = (m_next + 1) % m_length;
+
+  sample.time = time::system_clock::now();
+  sample.nInterests = 0;
+  sample.faces.clear();
+
+  for (auto it = m_faces.begin(); it != m_faces.end(); )
+    {
+      FaceCounters& counters = *it->second;
+      const bool isIdle = counters.nInterests == 0 && counters.nData == 0 &&
+                          counters.nTimeouts == 0 && counters.nDemotions == 0;
+      if (!isIdle)
+        {
+          counters.nIdleSeconds = 0;
+        }
+      else if (++counters.nIdleSeconds >= MAX_IDLE_SECONDS && counters.nInFlight == 0)
+        {
+          // counters the strategy still holds stay, out of the samples
+          if (it->second.use_count() == 1)
+            it = m_faces.erase(it);
+          else
+            ++it;
+          continue;
+        }
+
+      sample.nInterests += counters.nInterests;
+
+      FaceSample face{it->first, counters.nInterests, counters.nData, counters.nTimeouts,
+                      counters.nDemotions, counters.nInFlight,
+                      time::microseconds(static_cast<int64_t>(counters.srttUs))};
+      if (sample.faces.size() < MAX_FACES_PER_SAMPLE)
+        {
+          sample.faces.push_back(face);
+        }
+      else
+        {
+          // keep the busiest faces, without growing the sample
+          auto quietest = std::min_element(sample.faces.begin(), sample.faces.end(),
+                                           [] (const FaceSample& a, const FaceSample& b) {
+                                             return a.nInterests < b.nInterests;
+                                           });
+          if (quietest->nInterests < face.nInterests)
+            *quietest = face;
+        }
+
+      counters.nInterests = 0;
+      counters.nData = 0;
+      counters.nTimeouts = 0;
+      counters.nDemotions = 0;
+      ++it;
+    }
+}
+
+void
+StrategyHistory::writeJson(std::ostream& os, const time::seconds& length) const
+{
+  const size_t n = std::min<uint64_t>(m_samples.size(), std::max<int64_t>(length.count(), 0));
+
+  os << "{\"interval_s\": 1, \"length_s\": " << m_length << ", \"samples\": [";
+  for (size_t i = 0; i < n; ++i)
+    {
+      const Sample& sample = m_samples[(m_next + m_samples.size() - n + i) % m_samples.size()];
+
+      os << (i > 0 ? ", " : "")
+         << "{\"time_ms\": " << time::toUnixTimestamp(sample.time).count()
+         << ", \"interests\": " << sample.nInterests
+         << ", \"faces\": {";
+      for (size_t j = 0; j < sample.faces.size(); ++j)
+        {
+          const FaceSample& face = sample.faces[j];
+          os << (j > 0 ? ", " : "") << "\"" << face.faceId << "\": "
+             << "{\"share\": " << (sample.nInterests > 0 ?
+                                   static_cast<double>(face.nInterests) / sample.nInterests : 0)
+             << ", \"interests\": " << face.nInterests
+             << ", \"data\": " << face.nData
+             << ", \"timeouts\": " << face.nTimeouts
+             << ", \"demotions\": " << face.nDemotions
+             << ", \"in_flight\": " << face.nInFlight
+             << ", \"srtt_ms\": " << face.srtt.count() / 1000.0 << "}";
+        }
+      os << "}}";
+    }
+  os << "]}";
+}
+
+std::string
+StrategyHistory::dump(const std::string& path, const Name& strategyName) const
+{
+  const std::string file = makeInstancePath(path, strategyName, ".history.json");
+
+  std::ofstream os(file.c_str(), std::ios::trunc);
+  writeJson(os);
+  os << "\n";
+  if (!os)
+    throw std::runtime_error("cannot write " + file);
+
+  return file;
+}
+
+void
+StrategyHistory::setControlHandlers(const Name& strategyName)
+{
+  StrategyControl& control = StrategyControl::getInstance();
+
+  control.setHandler(strategyName, "history",
+                     [this] (const std::vector<std::string>& arguments, std::ostream& reply) {
+                       writeJson(reply, arguments.empty() ? time::seconds::max() :
+                                        time::seconds(std::stoll(arguments[0])));
+                     });
+
+  control.setHandler(strategyName, "history-dump",
+                     [this, strategyName] (const std::vector<std::string>& arguments,
+                                           std::ostream& reply) {
+                       if (arguments.size() != 1)
+                         throw std::invalid_argument("usage: history-dump PATH");
+
+                       const std::string file = dump(arguments[0], strategyName);
+                       reply << "{\"file\": ";
+                       writeJsonString(reply, file);
+                       reply << "}";
+                     });
+}
+
+} // namespace fw
+} // namespace nfd
@@ -0,0 +1,206 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_STRATEGY_HISTORY_HPP
+#define NFD_DAEMON_FW_STRATEGY_HISTORY_HPP
+
+#include "common.hpp"
+
+#include <unordered_map>
+
+#include "core/scheduler.hpp"
+
+namespace nfd {
+namespace fw {
+
+/** \brief per-second samples of a strategy's per-face metrics over the
+ *         last minutes
+ *
+ *  The forwarding path only increments the counters of a face, which the
+ *  strategy keeps with its own per-face state.  Once a second they are
+ *  moved into a ring of samples, which holds each face's share of the
+ *  Interests sent, its smoothed RTT, the Interests it has in flight and
+ *  its demotions in that second.  The ring grows to its length as
+ *  samples are taken, and samples keep the busiest faces only, so memory
+ *  is bounded by the length of the ring whatever the number of faces.
+ */
+class StrategyHistory : noncopyable
+{
+public:
+  /** \brief the counters of one face for the current second
+   */
+  struct FaceCounters
+  {
+    uint32_t nInterests = 0;
+    uint32_t nData = 0;
+    uint32_t nTimeouts = 0;
+    uint32_t nDemotions = 0;
+
+    /// see InFlight
+    uint32_t nInFlight = 0;
+    double srttUs = 0;
+
+    /// seconds without traffic, unused counters go after a minute
+    uint32_t nIdleSeconds = 0;
+  };
+
+  /** \brief counts an Interest in flight to a face while alive
+   *
+   *  Held by the strategy's PIT entry info for the faces of the entry's
+   *  last transmission, so the count follows the PIT however an entry
+   *  goes away, and a renewal to the same face adds nothing.
+   */
+  class InFlight : noncopyable
+  {
+  public:
+    InFlight(FaceId faceId, const shared_ptr<FaceCounters>& counters)
+      : m_faceId(faceId)
+      , m_counters(counters)
+      , m_sendTime(time::steady_clock::now())
+    {
+      ++m_counters->nInFlight;
+    }
+
+    InFlight(InFlight&& other) noexcept
+      : m_faceId(other.m_faceId)
+      , m_counters(std::move(other.m_counters))
+      , m_sendTime(other.m_sendTime)
+    {
+    }
+
+    ~InFlight()
+    {
+      if (m_counters != nullptr)
+        --m_counters->nInFlight;
+    }
+
+    FaceId
+    getFaceId() const
+    {
+      return m_faceId;
+    }
+
+    FaceCounters&
+    getCounters() const
+    {
+      return *m_counters;
+    }
+
+    const time::steady_clock::TimePoint&
+    getSendTime() const
+    {
+      return m_sendTime;
+    }
+
+  private:
+    FaceId m_faceId;
+    shared_ptr<FaceCounters> m_counters;
+    time::steady_clock::TimePoint m_sendTime;
+  };
+  struct FaceSample
+  {
+    FaceId faceId;
+    uint32_t nInterests;
+    uint32_t nData;
+    uint32_t nTimeouts;
+    uint32_t nDemotions;
+
+    /// at the end of the second
+    uint32_t nInFlight;
+
+    /// zero if never measured
+    time::microseconds srtt;
+  };
+
+  struct Sample
+  {
+    time::system_clock::TimePoint time;
+    uint64_t nInterests;
+    std::vector<FaceSample> faces;
+  };
+
+  static const size_t MAX_FACES_PER_SAMPLE;
+
+  /** \param length how far back samples go
+   */
+  explicit
+  StrategyHistory(const time::seconds& length);
+
+  ~StrategyHistory();
+
+  /** \return the counters of \p faceId, created if it has none
+   *
+   *  The strategy looks them up once and keeps them with its per-face
+   *  state; counters it still holds are never dropped.
+   */
+  shared_ptr<FaceCounters>
+  getCounters(FaceId faceId);
+
+  static void
+  countData(FaceCounters& counters, const time::nanoseconds& rtt);
+
+  /** \brief write the samples of the last \p length as a JSON object,
+   *         oldest first
+   */
+  void
+  writeJson(std::ostream& os, const time::seconds& length = time::seconds::max()) const;
+
+  /** \brief write all samples to \p path, see makeInstancePath
+   *  \return the file written
+   *  \throw std::runtime_error the file cannot be written
+   */
+  std::string
+  dump(const std::string& path, const Name& strategyName) const;
+
+  /** \brief serve the "history [SECONDS]" and "history-dump PATH" control
+   *         commands of \p strategyName
+   *
+   *  The strategy removes them with its other handlers.
+   */
+  void
+  setControlHandlers(const Name& strategyName);
+
+private:
+  void
+  takeSample();
+
+private:
+  std::unordered_map<FaceId, shared_ptr<FaceCounters>> m_faces;
+
+  /// samples the ring holds at most
+  size_t m_length;
+
+  /// the next sample goes to m_samples[m_next], appended until the ring
+  /// has its length
+  std::vector<Sample> m_samples;
+  size_t m_next;
+
+  scheduler::EventId m_sampling;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_STRATEGY_HISTORY_HPP
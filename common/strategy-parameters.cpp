@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "strategy-parameters.hpp"
+
+#include <cctype>
+#include <cstdlib>
+
+namespace nfd {
+namespace fw {
+
+StrategyParameters::StrategyParameters(const Name& name, const Name& strategyName)
+  : m_config(StrategyConfig::getCurrent())
+{
+  if (!strategyName.empty())
+    m_label.assign(reinterpret_cast<const char*>(strategyName.get(-1).value()),
+                   strategyName.get(-1).value_size());
+
+  for (size_t i = strategyName.size(); i < name.size(); ++i)
+    {
+      const name::Component& value = name.get(i);
+      const std::string component(reinterpret_cast<const char*>(value.value()), value.value_size());
+      auto parameter = parseComponent(component);
+      m_fromName[parameter.first] = parameter.second;
+    }
+}
+
+std::pair<std::string, std::string>
+StrategyParameters::parseComponent(const std::string& component)
+{
+  const size_t separator = component.find('=');
+  if (separator == std::string::npos || separator == 0)
+    throw Error("strategy parameter '" + component + "' is not key=value");
+
+  return std::make_pair(component.substr(0, separator), component.substr(separator + 1));
+}
+
+void
+StrategyParameters::update(const std::vector<std::string>& components,
+                           const std::set<std::string>& allowedKeys)
+{
+  std::map<std::string, std::string> updates;
+  for (const auto& component : components)
+    {
+      auto parameter = parseComponent(component);
+      if (allowedKeys.count(parameter.first) == 0)
+        throw Error("strategy parameter " + parameter.first + " cannot change at runtime");
+      updates[parameter.first] = parameter.second;
+    }
+
+  for (const auto& parameter : updates)
+    m_fromName[parameter.first] = parameter.second;
+}
+
+std::vector<std::string>
+StrategyParameters::select(const std::vector<std::string>& components,
+                           const std::set<std::string>& keys)
+{
+  std::vector<std::string> selected;
+  for (const auto& component : components)
+    {
+      if (keys.count(parseComponent(component).first) > 0)
+        selected.push_back(component);
+    }
+  return selected;
+}
+
+void
+StrategyParameters::setConfig(const shared_ptr<const StrategyConfig>& config)
+{
+  m_config = config;
+}
+
+std::vector<std::string>
+StrategyParameters::findChanges(const StrategyParameters& other,
+                                const std::set<std::string>& keys) const
+{
+  std::vector<std::string> changes;
+  for (const auto& key : keys)
+    {
+      std::string value;
+      std::string otherValue;
+      const bool isSet = find(key, value);
+      if (isSet != other.find(key, otherValue) || value != otherValue)
+        changes.push_back(key + "=" + value);
+    }
+  return changes;
+}
+
+bool
+StrategyParameters::find(const std::string& key, std::string& value) const
+{
+  auto it = m_fromName.find(key);
+  if (it != m_fromName.end())
+    {
+      value = it->second;
+    }
+  else
+    {
+      std::string variable = "NFD_STRATEGY_" + key;
+      for (auto& c : variable)
+        c = c == '-' ? '_' : static_cast<char>(std::toupper(c));
+
+      const char* fromEnvironment = std::getenv(variable.c_str());
+      if (fromEnvironment != nullptr)
+        value = fromEnvironment;
+      else if (!m_config->find(m_label, key, value))
+        {
+          // it may have been set by a configuration since replaced
+          m_used.erase(key);
+          return false;
+        }
+    }
+
+  m_used[key] = value;
+  return true;
+}
+
+bool
+StrategyParameters::has(const std::string& key) const
+{
+  std::string value;
+  return find(key, value);
+}
+
+std::string
+StrategyParameters::get(const std::string& key, const std::string& defaultValue) const
+{
+  std::string value;
+  return find(key, value) ? value : defaultValue;
+}
+
+uint64_t
+StrategyParameters::getUnsigned(const std::string& key, uint64_t defaultValue) const
+{
+  std::string value;
+  if (!find(key, value))
+    return defaultValue;
+
+  char* end = nullptr;
+  const uint64_t number = std::strtoull(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0' || value[0] == '-')
+    throw Error("strategy parameter " + key + "=" + value + " is not an unsigned integer");
+  return number;
+}
+
+double
+StrategyParameters::getDouble(const std::string& key, double defaultValue) const
+{
+  std::string value;
+  if (!find(key, value))
+    return defaultValue;
+
+  char* end = nullptr;
+  const double number = std::strtod(value.c_str(), &end);
+  if (value.empty() || *end != '\0')
+    throw Error("strategy parameter " + key + "=" + value + " is not a number");
+  return number;
+}
+
+Name
+StrategyParameters::makeName(const Name& strategyName,
+                             const std::set<std::string>& excluded) const
+{
+  Name name(strategyName);
+  for (const auto& parameter : m_used)
+    {
+      if (excluded.count(parameter.first) == 0)
+        name.append(name::Component(parameter.first + "=" + parameter.second));
+    }
+  return name;
+}
+
+} // namespace fw
+} // namespace nfd
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_STRATEGY_PARAMETERS_HPP
+#define NFD_DAEMON_FW_STRATEGY_PARAMETERS_HPP
+
+#include "common.hpp"
+#include "strategy-config.hpp"
+
+namespace nfd {
+namespace fw {
+
+/** \brief key=value parameters of a strategy instance
+ *
+ *  Parameters are the name components following the strategy's own name,
+ *  e.g. /localhost/nfd/strategy/weighted-load-balancer/seed=42.  A key
+ *  missing from the name is taken from the environment variable
+ *  NFD_STRATEGY_<KEY> (upper case, '-' replaced by '_'), and failing that
+ *  from the strategy_defaults section of nfd.conf, see StrategyConfig.
+ *  This is how the instances NFD creates at startup are configured.
+ *
+ *  Every value that is looked up is remembered, so that makeName() can
+ *  rebuild a name that configures another instance identically.
+ */
+class StrategyParameters
+{
+public:
+  class Error : public std::invalid_argument
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::invalid_argument(what)
+    {
+    }
+  };
+
+  /** \throw Error a component after \p strategyName is not key=value
+   */
+  StrategyParameters(const Name& name, const Name& strategyName);
+
+  /** \brief override parameters with "key=value" \p components, as if
+   *         they followed the strategy name
+   *  \throw Error a component is not key=value, or its key is not in
+   *         \p allowedKeys
+   */
+  void
+  update(const std::vector<std::string>& components, const std::set<std::string>& allowedKeys);
+
+  /** \return the "key=value" \p components whose key is in \p keys
+   *  \throw Error a component is not key=value
+   */
+  static std::vector<std::string>
+  select(const std::vector<std::string>& components, const std::set<std::string>& keys);
+
+  /** \brief take the defaults from \p config from now on
+   */
+  void
+  setConfig(const shared_ptr<const StrategyConfig>& config);
+
+  /** \return "key=value" for each of \p keys whose value differs in
+   *          \p other, with an empty value if it is unset here
+   */
+  std::vector<std::string>
+  findChanges(const StrategyParameters& other, const std::set<std::string>& keys) const;
+
+  bool
+  has(const std::string& key) const;
+
+  std::string
+  get(const std::string& key, const std::string& defaultValue = "") const;
+
+  /** \throw Error the value is not an unsigned integer
+   */
+  uint64_t
+  getUnsigned(const std::string& key, uint64_t defaultValue) const;
+
+  /** \throw Error the value is not a number
+   */
+  double
+  getDouble(const std::string& key, double defaultValue) const;
+
+  /** \return \p strategyName followed by every parameter looked up so far,
+   *          except those in \p excluded
+   */
+  Name
+  makeName(const Name& strategyName, const std::set<std::string>& excluded) const;
+
+private:
+  /** \brief split a key=value component
+   *  \throw Error it is not key=value
+   */
+  static std::pair<std::string, std::string>
+  parseComponent(const std::string& component);
+
+  bool
+  find(const std::string& key, std::string& value) const;
+
+private:
+  std::map<std::string, std::string> m_fromName;
+
+  /// defaults of the strategy named m_label
+  shared_ptr<const StrategyConfig> m_config;
+  std::string m_label;
+  mutable std::map<std::string, std::string> m_used;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_STRATEGY_PARAMETERS_HPP
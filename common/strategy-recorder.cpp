@@ -0,0 +1,316 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "strategy-recorder.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <unistd.h>
+
+namespace nfd {
+namespace fw {
+
+static const char LOG_MAGIC[] = {'N', 'L', 'B', 'R'};
+static const uint8_t LOG_VERSION = 1;
+
+static inline uint64_t
+zigzag(int64_t value)
+{
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static inline int64_t
+unzigzag(uint64_t value)
+{
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+std::string
+makeInstancePath(const std::string& path, const Name& strategyName,
+                 const std::string& extension)
+{
+  if (!boost::filesystem::is_directory(path))
+    return path;
+
+  // one log per strategy and process, so instances can share the setting;
+  // the label is the last component that is not a parameter
+  std::string label;
+  for (size_t i = strategyName.size();
+       i > 0 && (label.empty() || label.find('=') != std::string::npos); --i)
+    {
+      const name::Component& component = strategyName.get(i - 1);
+      label.assign(reinterpret_cast<const char*>(component.value()), component.value_size());
+    }
+
+  return (boost::filesystem::path(path) /
+          (label + "-" + std::to_string(getpid()) + extension)).string();
+}
+
+const std::set<std::string> StrategyRecorder::LOCAL_PARAMETERS = {
+  "seed", "record", "control", "control-group", "shared-table", "shared-table-capacity", "history"
+};
+
+const std::string StrategyRecorder::UNRECORDED_PARAMETER = "unrecorded";
+
+Name
+StrategyRecorder::makeRecordedName(const StrategyParameters& parameters, const Name& strategyName,
+                                   const std::vector<std::string>& unrecorded)
+{
+  Name name = parameters.makeName(strategyName, LOCAL_PARAMETERS);
+  if (!unrecorded.empty())
+    {
+      std::string list;
+      for (const auto& feature : unrecorded)
+        list += (list.empty() ? "" : ",") + feature;
+      name.append(name::Component(UNRECORDED_PARAMETER + "=" + list));
+    }
+  return name;
+}
+
+StrategyRecorder::StrategyRecorder(const std::string& path, const Name& strategyName,
+                                   uint64_t seed)
+  : m_log(makeInstancePath(path, strategyName, ".rec").c_str(),
+          std::ios::binary | std::ios::trunc)
+  , m_lastSteadyNs(0)
+  , m_lastSystemNs(0)
+{
+  if (!m_log)
+    throw Error("cannot create strategy log " + makeInstancePath(path, strategyName, ".rec"));
+
+  m_log.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+  m_log.put(LOG_VERSION);
+  writeBlock(strategyName.wireEncode());
+  writeNumber(seed);
+}
+
+void
+StrategyRecorder::recordInterest(const Face& inFace, const Interest& interest,
+                                 const fib::Entry& fibEntry)
+{
+  noteFace(inFace);
+  for (const auto& hop : fibEntry.getNextHops())
+    noteFace(*hop.getFace());
+
+  m_log.put(STRATEGY_RECORD_INTEREST);
+  writeTimes();
+  writeNumber(inFace.getId());
+  writeBlock(interest.wireEncode());
+  writeBlock(fibEntry.getPrefix().wireEncode());
+  writeNumber(fibEntry.getNextHops().size());
+  for (const auto& hop : fibEntry.getNextHops())
+    {
+      writeNumber(hop.getFace()->getId());
+      writeNumber(hop.getCost());
+    }
+}
+
+void
+StrategyRecorder::recordData(const Face& inFace, const pit::Entry& pitEntry, const Data& data)
+{
+  noteFace(inFace);
+
+  m_log.put(STRATEGY_RECORD_DATA);
+  writeTimes();
+  writeNumber(inFace.getId());
+  writeBlock(pitEntry.getInterest().wireEncode());
+  writeBlock(data.getName().wireEncode());
+}
+
+void
+StrategyRecorder::recordExpire(const pit::Entry& pitEntry)
+{
+  m_log.put(STRATEGY_RECORD_EXPIRE);
+  writeTimes();
+  writeBlock(pitEntry.getInterest().wireEncode());
+}
+
+void
+StrategyRecorder::recordForward(const Face& outFace)
+{
+  m_log.put(STRATEGY_RECORD_FORWARD);
+  writeNumber(outFace.getId());
+}
+
+void
+StrategyRecorder::recordReject()
+{
+  m_log.put(STRATEGY_RECORD_REJECT);
+}
+
+void
+StrategyRecorder::recordHold()
+{
+  m_log.put(STRATEGY_RECORD_HOLD);
+}
+
+void
+StrategyRecorder::noteFace(const Face& face)
+{
+  if (!m_knownFaces.insert(face.getId()).second)
+    return;
+
+  m_log.put(STRATEGY_RECORD_FACE);
+  writeNumber(face.getId());
+  writeNumber(face.isLocal() ? 1 : 0);
+}
+
+void
+StrategyRecorder::writeTimes()
+{
+  const int64_t steadyNs = time::steady_clock::now().time_since_epoch().count();
+  const int64_t systemNs = time::system_clock::now().time_since_epoch().count();
+
+  writeNumber(zigzag(steadyNs - m_lastSteadyNs));
+  writeNumber(zigzag(systemNs - m_lastSystemNs));
+  m_lastSteadyNs = steadyNs;
+  m_lastSystemNs = systemNs;
+}
+
+void
+StrategyRecorder::writeNumber(uint64_t number)
+{
+  while (number >= 0x80)
+    {
+      m_log.put(static_cast<char>(number | 0x80));
+      number >>= 7;
+    }
+  m_log.put(static_cast<char>(number));
+}
+
+void
+StrategyRecorder::writeBlock(const Block& block)
+{
+  writeNumber(block.size());
+  m_log.write(reinterpret_cast<const char*>(block.wire()), block.size());
+}
+
+StrategyLogReader::StrategyLogReader(const std::string& path)
+  : m_log(path.c_str(), std::ios::binary)
+  , m_seed(0)
+  , m_lastSteadyNs(0)
+  , m_lastSystemNs(0)
+{
+  if (!m_log)
+    throw Error("cannot open strategy log " + path);
+
+  char magic[sizeof(LOG_MAGIC)];
+  m_log.read(magic, sizeof(magic));
+  if (!m_log || !std::equal(magic, magic + sizeof(magic), LOG_MAGIC) ||
+      m_log.get() != LOG_VERSION)
+    throw Error(path + " is not a strategy log of version " + std::to_string(LOG_VERSION));
+
+  m_strategyName.wireDecode(readBlock());
+  m_seed = readNumber();
+}
+
+bool
+StrategyLogReader::read(Record& record)
+{
+  const int type = m_log.get();
+  if (type == std::char_traits<char>::eof())
+    return false;
+
+  record = Record();
+  record.type = static_cast<StrategyRecordType>(type);
+
+  if (type == STRATEGY_RECORD_INTEREST || type == STRATEGY_RECORD_DATA ||
+      type == STRATEGY_RECORD_EXPIRE)
+    {
+      m_lastSteadyNs += unzigzag(readNumber());
+      m_lastSystemNs += unzigzag(readNumber());
+      record.steadyTime = time::steady_clock::TimePoint(time::nanoseconds(m_lastSteadyNs));
+      record.systemTime = time::system_clock::TimePoint(time::nanoseconds(m_lastSystemNs));
+    }
+
+  switch (type)
+    {
+    case STRATEGY_RECORD_FACE:
+      record.faceId = readNumber();
+      record.isLocal = readNumber() != 0;
+      break;
+    case STRATEGY_RECORD_INTEREST:
+      {
+        record.faceId = readNumber();
+        record.interest = make_shared<Interest>(readBlock());
+        record.prefix.wireDecode(readBlock());
+        const uint64_t nNextHops = readNumber();
+        for (uint64_t i = 0; i < nNextHops; ++i)
+          {
+            const FaceId faceId = readNumber();
+            record.nexthops.push_back(std::make_pair(faceId, readNumber()));
+          }
+        break;
+      }
+    case STRATEGY_RECORD_DATA:
+      record.faceId = readNumber();
+      record.interest = make_shared<Interest>(readBlock());
+      record.dataName.wireDecode(readBlock());
+      break;
+    case STRATEGY_RECORD_EXPIRE:
+      record.interest = make_shared<Interest>(readBlock());
+      break;
+    case STRATEGY_RECORD_FORWARD:
+      record.faceId = readNumber();
+      break;
+    case STRATEGY_RECORD_REJECT:
+    case STRATEGY_RECORD_HOLD:
+      break;
+    default:
+      throw Error("unknown record type " + std::to_string(type));
+    }
+
+  return true;
+}
+
+uint64_t
+StrategyLogReader::readNumber()
+{
+  uint64_t number = 0;
+  for (int shift = 0; shift < 64; shift += 7)
+    {
+      const int byte = m_log.get();
+      if (byte == std::char_traits<char>::eof())
+        throw Error("strategy log is truncated");
+
+      number |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0)
+        return number;
+    }
+  throw Error("malformed number in strategy log");
+}
+
+Block
+StrategyLogReader::readBlock()
+{
+  const uint64_t size = readNumber();
+  auto buffer = make_shared<ndn::Buffer>(size);
+  m_log.read(reinterpret_cast<char*>(buffer->buf()), size);
+  if (static_cast<uint64_t>(m_log.gcount()) != size)
+    throw Error("strategy log is truncated");
+  return Block(buffer);
+}
+
+} // namespace fw
+} // namespace nfd
@@ -0,0 +1,216 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_STRATEGY_RECORDER_HPP
+#define NFD_DAEMON_FW_STRATEGY_RECORDER_HPP
+
+#include <fstream>
+
+#include "strategy-parameters.hpp"
+
+#include "face/face.hpp"
+#include "table/fib-entry.hpp"
+#include "table/pit-entry.hpp"
+
+namespace nfd {
+namespace fw {
+
+/** \brief types of the records in a strategy log
+ *
+ *  A log starts with the magic "NLBR", the format version, the strategy
+ *  name and the RNG seed.  Every record is its type followed by
+ *  variable-length integers and TLV blocks:
+ *
+ *  - FACE: FaceId, isLocal; written before the first record using the face
+ *  - INTEREST: times, in-face, Interest, FIB prefix, nexthops (FaceId, cost)
+ *  - DATA: times, in-face, Interest of the PIT entry, Data name
+ *  - EXPIRE: times, Interest of the PIT entry
+ *  - FORWARD: FaceId the strategy sent the Interest to
+ *  - REJECT: the strategy rejected the pending Interest
+ *  - HOLD: the strategy held a retransmission back, leaving the PIT entry
+ *    pending on its earlier upstreams (retry budget)
+ *
+ *  Times are the steady and system clock, as differences from the
+ *  previous record in nanoseconds.
+ */
+enum StrategyRecordType : uint8_t {
+  STRATEGY_RECORD_FACE = 1,
+  STRATEGY_RECORD_INTEREST = 2,
+  STRATEGY_RECORD_DATA = 3,
+  STRATEGY_RECORD_EXPIRE = 4,
+  STRATEGY_RECORD_FORWARD = 5,
+  STRATEGY_RECORD_REJECT = 6,
+  STRATEGY_RECORD_HOLD = 7
+};
+
+/** \return \p path, or if it is a directory, the file in it named after
+ *          the strategy and the process ID with \p extension
+ */
+std::string
+makeInstancePath(const std::string& path, const Name& strategyName,
+                 const std::string& extension);
+
+/** \brief writes every input of a strategy and every decision it takes
+ *         to a compact binary log, for offline replay
+ *
+ *  See benchmarks/strategy-replay.cpp.
+ */
+class StrategyRecorder : noncopyable
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  /** \param path log file, or a directory in which the log is named
+   *              after the strategy and the process ID
+   *  \throw Error the log cannot be created
+   */
+  StrategyRecorder(const std::string& path, const Name& strategyName, uint64_t seed);
+
+  /** \return the name to record for an instance with \p parameters
+   *
+   *  LOCAL_PARAMETERS are left out.  \p unrecorded names the enabled
+   *  features whose inputs to the decisions the log does not hold; they go
+   *  into an UNRECORDED_PARAMETER component, and strategy-replay refuses
+   *  such a log.
+   */
+  static Name
+  makeRecordedName(const StrategyParameters& parameters, const Name& strategyName,
+                   const std::vector<std::string>& unrecorded);
+
+  /// parameters that act outside the strategy (sockets, shared files,
+  /// dumps) or that the log holds apart, so a replay must not inherit them
+  static const std::set<std::string> LOCAL_PARAMETERS;
+
+  static const std::string UNRECORDED_PARAMETER;
+
+  void
+  recordInterest(const Face& inFace, const Interest& interest, const fib::Entry& fibEntry);
+
+  void
+  recordData(const Face& inFace, const pit::Entry& pitEntry, const Data& data);
+
+  void
+  recordExpire(const pit::Entry& pitEntry);
+
+  void
+  recordForward(const Face& outFace);
+
+  void
+  recordReject();
+
+  void
+  recordHold();
+
+private:
+  void
+  noteFace(const Face& face);
+
+  void
+  writeTimes();
+
+  void
+  writeNumber(uint64_t number);
+
+  void
+  writeBlock(const Block& block);
+
+private:
+  std::ofstream m_log;
+  std::set<FaceId> m_knownFaces;
+  int64_t m_lastSteadyNs;
+  int64_t m_lastSystemNs;
+};
+
+/** \brief reads a log written by StrategyRecorder
+ */
+class StrategyLogReader : noncopyable
+{
+public:
+  typedef StrategyRecorder::Error Error;
+
+  struct Record
+  {
+    StrategyRecordType type;
+    time::steady_clock::TimePoint steadyTime;
+    time::system_clock::TimePoint systemTime;
+    FaceId faceId;
+    bool isLocal;
+    shared_ptr<Interest> interest;
+    Name prefix;
+    std::vector<std::pair<FaceId, uint64_t>> nexthops;
+    Name dataName;
+  };
+
+  /** \throw Error the file cannot be opened or is not a strategy log
+   */
+  explicit
+  StrategyLogReader(const std::string& path);
+
+  const Name&
+  getStrategyName() const
+  {
+    return m_strategyName;
+  }
+
+  uint64_t
+  getSeed() const
+  {
+    return m_seed;
+  }
+
+  /** \brief read the next record
+   *  \return false at the end of the log
+   *  \throw Error the log is truncated or corrupt
+   */
+  bool
+  read(Record& record);
+
+private:
+  uint64_t
+  readNumber();
+
+  Block
+  readBlock();
+
+private:
+  std::ifstream m_log;
+  Name m_strategyName;
+  uint64_t m_seed;
+  int64_t m_lastSteadyNs;
+  int64_t m_lastSystemNs;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_STRATEGY_RECORDER_HPP
@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "strategy-stats.hpp"
+
+#include <cmath>
+
+namespace nfd {
+namespace fw {
+
+LatencyHistogram::LatencyHistogram()
+  : m_buckets(N_BUCKETS, 0)
+  , m_count(0)
+  , m_sumMs(0)
+{
+}
+
+void
+LatencyHistogram::add(const time::nanoseconds& latency)
+{
+  const double ms = latency.count() / 1e6;
+  size_t bucket = 0;
+  if (ms > 1)
+    bucket = std::min<size_t>(N_BUCKETS - 1, static_cast<size_t>(std::ceil(4 * std::log2(ms))));
+
+  ++m_buckets[bucket];
+  ++m_count;
+  m_sumMs += ms;
+}
+
+double
+LatencyHistogram::getMean() const
+{
+  return m_count > 0 ? m_sumMs / m_count : 0;
+}
+
+double
+LatencyHistogram::getPercentile(double fraction) const
+{
+  if (m_count == 0)
+    return 0;
+
+  const double rank = fraction * m_count;
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < N_BUCKETS; ++bucket)
+    {
+      seen += m_buckets[bucket];
+      if (seen >= rank && seen > 0)
+        return std::pow(2, bucket / 4.0);
+    }
+  return std::pow(2, (N_BUCKETS - 1) / 4.0);
+}
+
+void
+LatencyHistogram::writeJson(std::ostream& os) const
+{
+  os << "{\"mean\": " << getMean()
+     << ", \"p50\": " << getPercentile(0.5)
+     << ", \"p99\": " << getPercentile(0.99) << "}";
+}
+
+void
+ForwardingStats::writeJsonMembers(std::ostream& os) const
+{
+  os << "\"interests\": " << nInterests
+     << ", \"upstream_interests\": " << nUpstreamInterests
+     << ", \"data\": " << nData
+     << ", \"timeouts\": " << nTimeouts
+     << ", \"rejected\": " << nRejected
+     << ", \"satisfaction\": "
+     << (nInterests > 0 ? static_cast<double>(nData) / nInterests : 0)
+     << ", \"upstream_overhead\": "
+     << (nInterests > 0 ? static_cast<double>(nUpstreamInterests) / nInterests : 0)
+     << ", \"latency_ms\": ";
+  latency.writeJson(os);
+}
+
+} // namespace fw
+} // namespace nfd
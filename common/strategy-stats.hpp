@@ -0,0 +1,100 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * Copyright (c) 2014,  Regents of the University of California,
+ *                      Arizona Board of Regents,
+ *                      Colorado State University,
+ *                      University Pierre & Marie Curie, Sorbonne University,
+ *                      Washington University in St. Louis,
+ *                      Beijing Institute of Technology,
+ *                      The University of Memphis
+ *
+ * This file is part of NFD (Named Data Networking Forwarding Daemon).
+ * See AUTHORS.md for complete list of NFD authors and contributors.
+ *
+ * NFD is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU General Public License as published by the Free Software Foundation,
+ * either version 3 of the License, or (at your option) any later version.
+ *
+ * NFD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * NFD, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NFD_DAEMON_FW_STRATEGY_STATS_HPP
+#define NFD_DAEMON_FW_STRATEGY_STATS_HPP
+
+#include "common.hpp"
+
+namespace nfd {
+namespace fw {
+
+/** \brief latency histogram with buckets a quarter-octave wide
+ *
+ *  Bucket i holds latencies up to 2^(i/4) ms, so percentiles are accurate
+ *  to about 19%; the last bucket holds everything above 2^(63/4) ms.
+ */
+class LatencyHistogram
+{
+public:
+  LatencyHistogram();
+
+  void
+  add(const time::nanoseconds& latency);
+
+  uint64_t
+  getCount() const
+  {
+    return m_count;
+  }
+
+  /** \return mean latency in ms, 0 if empty
+   */
+  double
+  getMean() const;
+
+  /** \return upper bound in ms of the bucket holding the given fraction
+   *          of the latencies, 0 if empty
+   */
+  double
+  getPercentile(double fraction) const;
+
+  void
+  writeJson(std::ostream& os) const;
+
+private:
+  static const size_t N_BUCKETS = 64;
+  std::vector<uint64_t> m_buckets;
+  uint64_t m_count;
+  double m_sumMs;
+};
+
+/** \brief forwarding counters of a strategy, or of one arm of an experiment
+ */
+struct ForwardingStats
+{
+  /// Interests that created a PIT entry handled by the strategy
+  uint64_t nInterests = 0;
+
+  /// Interests the strategy sent upstream, retransmissions included
+  uint64_t nUpstreamInterests = 0;
+
+  uint64_t nData = 0;
+  uint64_t nTimeouts = 0;
+  uint64_t nRejected = 0;
+
+  LatencyHistogram latency;
+
+  /** \brief write the counters, satisfaction ratio, upstream overhead and
+   *         latency as the members of a JSON object, without the braces
+   */
+  void
+  writeJsonMembers(std::ostream& os) const;
+};
+
+} // namespace fw
+} // namespace nfd
+
+#endif // NFD_DAEMON_FW_STRATEGY_STATS_HPP
@@ -25,6 +25,9 @@
 
 
 #include "random-load-balancer-strategy.hpp"
+#include "strategy-control.hpp"
+
+#include <random>
 
 #include <boost/random/uniform_int_distribution.hpp>
 
@@ -41,13 +44,145 @@ namespace fw {
 const Name RandomLoadBalancerStrategy::STRATEGY_NAME("ndn:/localhost/nfd/strategy/random-load-balancer");
 NFD_REGISTER_STRATEGY(RandomLoadBalancerStrategy);
 
+const std::set<std::string> RandomLoadBalancerStrategy::LIVE_PARAMETERS = {
+  "replicas", "retry-budget-ratio", "retry-budget-window", "retry-budget-min",
+  "shed-pit-high", "shed-pit-low", "shed-pending-high", "shed-pending-low", "shed-classes"
+};
+
+const uint32_t RandomLoadBalancerStrategy::UNHEALTHY_TIMEOUTS = 3;
+const time::milliseconds RandomLoadBalancerStrategy::INITIAL_BACKOFF(1000);
+const time::milliseconds RandomLoadBalancerStrategy::MAX_BACKOFF(64000);
+
 RandomLoadBalancerStrategy::RandomLoadBalancerStrategy(Forwarder& forwarder, const Name& name)
   : Strategy(forwarder, name)
+  , m_parameters(name, STRATEGY_NAME)
+  , m_nInterests(0)
+  , m_nUpstreamInterests(0)
+  , m_nPendingInterests(make_shared<size_t>(0))
+  , m_pit(forwarder.getPit())
+  , m_nTrials(0)
+{
+  const StrategyParameters& parameters = m_parameters;
+
+  // an explicit seed makes the choices reproducible, see strategy-replay
+  const uint64_t seed = parameters.getUnsigned("seed", std::random_device()());
+  m_randomGenerator.seed(static_cast<uint32_t>(seed));
+
+  configure(parameters);
+
+  m_afterFaceRemove = forwarder.getFaceTable().onRemove.connect(
+    [this] (shared_ptr<Face> face) {
+      m_faceHealth.erase(face->getId());
+    });
+
+  if (parameters.has("shared-table"))
+    {
+      m_sharedFaces = SharedFaceTable::open(parameters.get("shared-table"),
+                                            forwarder.getFaceTable(),
+                                            parameters.getUnsigned("shared-table-capacity", 4096));
+    }
+
+  StrategyControl& control = StrategyControl::getInstance();
+  if (parameters.has("control"))
+    control.listen(parameters.get("control"), parameters.get("control-group"));
+  control.setHandler(getName(), "stats",
+                     [this] (const std::vector<std::string>&, std::ostream& reply) {
+                       writeStats(reply);
+                     });
+  control.setCheckedHandler(getName(), "set",
+                            [this] (const std::vector<std::string>& arguments,
+                                    std::vector<std::string>& accepted) {
+                              return reconfigure(arguments, accepted);
+                            });
+  control.setCheckedHandler(getName(), StrategyConfig::RELOAD_COMMAND,
+                            [this] (const std::vector<std::string>&,
+                                    std::vector<std::string>& changed) {
+                              return reloadDefaults(changed);
+                            });
+
+  if (parameters.has("record"))
+    {
+      // shared records are an input the log does not hold
+      std::vector<std::string> unrecorded;
+      if (m_sharedFaces != nullptr)
+        {
+          unrecorded.push_back("shared-table");
+          NFD_LOG_WARN("the log of " << getName() << " will not replay, it lacks the "
+                       "shared-table inputs");
+        }
+
+      m_recorder.reset(new StrategyRecorder(parameters.get("record"),
+                                            StrategyRecorder::makeRecordedName(parameters,
+                                                                               STRATEGY_NAME,
+                                                                               unrecorded),
+                                            seed));
+    }
+
+  if (parameters.getUnsigned("history", 0) > 0)
+    {
+      m_history.reset(new StrategyHistory(time::seconds(60 * parameters.getUnsigned("history", 0))));
+      m_history->setControlHandlers(getName());
+    }
+}
+
+void
+RandomLoadBalancerStrategy::configure(const StrategyParameters& parameters, bool isDryRun)
+{
+  const size_t nReplicas = std::max<uint64_t>(parameters.getUnsigned("replicas", 1), 1);
+  const double retryRatio = parameters.getDouble("retry-budget-ratio", 0);
+  const time::seconds retryWindow(parameters.getUnsigned("retry-budget-window", 10));
+  const double retryMin = parameters.getDouble("retry-budget-min", 10);
+  const LoadShedder loadShedder(parameters);
+
+  // nothing below throws
+  if (isDryRun)
+    return;
+
+  m_nReplicas = nReplicas;
+  m_retryBudget.setLimits(retryRatio, retryWindow, retryMin);
+  m_loadShedder.setLimits(loadShedder);
+}
+
+StrategyControl::Action
+RandomLoadBalancerStrategy::reconfigure(const std::vector<std::string>& arguments,
+                                        std::vector<std::string>& accepted)
+{
+  accepted = StrategyParameters::select(arguments, LIVE_PARAMETERS);
+
+  StrategyParameters parameters = m_parameters;
+  parameters.update(accepted, LIVE_PARAMETERS);
+  return prepareParameters(parameters);
+}
+
+StrategyControl::Action
+RandomLoadBalancerStrategy::reloadDefaults(std::vector<std::string>& changed)
+{
+  StrategyParameters parameters = m_parameters;
+  parameters.setConfig(StrategyConfig::getCurrent());
+  changed = parameters.findChanges(m_parameters, LIVE_PARAMETERS);
+  return prepareParameters(parameters);
+}
+
+StrategyControl::Action
+RandomLoadBalancerStrategy::prepareParameters(const StrategyParameters& parameters)
 {
+  configure(parameters, true);
+
+  return [this, parameters] (std::ostream& reply) {
+      configure(parameters);
+      m_parameters = parameters;
+
+      NFD_LOG_INFO("reconfigured " << getName());
+
+      reply << "{\"parameters\": ";
+      writeJsonString(reply, m_parameters.makeName(STRATEGY_NAME, {}).toUri());
+      reply << "}";
+    };
 }
 
 RandomLoadBalancerStrategy::~RandomLoadBalancerStrategy()
 {
+  StrategyControl::getInstance().removeHandlers(getName());
 }
 
 static bool
@@ -71,36 +206,321 @@ RandomLoadBalancerStrategy::afterReceiveInterest(const Face& inFace,
                                                  shared_ptr<fib::Entry> fibEntry,
                                                  shared_ptr<pit::Entry> pitEntry)
 {
+  if (m_recorder != nullptr)
+    m_recorder->recordInterest(inFace, interest, *fibEntry);
+
   if (pitEntry->hasUnexpiredOutRecords())
     {
       // not a new Interest, don't forward
       return;
     }
 
+  auto pitEntryInfo = pitEntry->getStrategyInfo<RandomPitInfo>();
+  if (pitEntryInfo == nullptr)
+    {
+      pitEntryInfo = make_shared<RandomPitInfo>(m_nPendingInterests);
+      pitEntry->setStrategyInfo(pitEntryInfo);
+    }
+
   const fib::NextHopList& nexthops = fibEntry->getNextHops();
+  ++m_nInterests;
 
   // Ensure there is at least 1 Face is available for forwarding
   if (!hasFaceForForwarding(nexthops, pitEntry))
     {
+      if (m_recorder != nullptr)
+        m_recorder->recordReject();
+
+      endTrials(*pitEntry, INVALID_FACEID);
+      this->rejectPendingInterest(pitEntry);
+      return;
+    }
+
+  // under PIT pressure, don't let Interests wait out their lifetime on a
+  // prefix whose every face keeps timing out
+  if (m_loadShedder.isEnabled() && !hasHealthyFace(nexthops) &&
+      m_loadShedder.shouldShed(interest.getName(), m_pit.size(), *m_nPendingInterests))
+    {
+      if (m_recorder != nullptr)
+        m_recorder->recordReject();
+
+      endTrials(*pitEntry, INVALID_FACEID);
       this->rejectPendingInterest(pitEntry);
       return;
     }
 
-  fib::NextHopList::const_iterator selected;
-  do
+  auto selected = selectFaces(nexthops, pitEntry, true);
+  if (selected.empty())
+    {
+      // every face is backing off: a likely timeout beats certain failure
+      selected = selectFaces(nexthops, pitEntry, false);
+    }
+
+  // retransmissions draw from the retry budget, first transmissions fill
+  // it; only Interests that are sent count
+  if (pitEntry->getOutRecords().empty())
+    {
+      m_retryBudget.deposit();
+    }
+  else if (!m_retryBudget.tryWithdraw())
+    {
+      if (m_recorder != nullptr)
+        m_recorder->recordHold();
+      return;
+    }
+
+  // with several faces, the first Data satisfies the Interest and the
+  // PIT absorbs the others
+  const auto now = time::steady_clock::now();
+  if (m_history != nullptr)
+    pitEntryInfo->inFlight.clear();
+  for (const auto& face : selected)
+    {
+      auto health = m_faceHealth.find(face->getId());
+      if (m_history != nullptr)
+        {
+          // the counters stay with the face's health, found here anyway
+          if (health == m_faceHealth.end())
+            health = m_faceHealth.emplace(face->getId(), FaceHealth()).first;
+          if (health->second.history == nullptr)
+            health->second.history = m_history->getCounters(face->getId());
+
+          ++health->second.history->nInterests;
+          pitEntryInfo->inFlight.emplace_back(face->getId(), health->second.history);
+        }
+
+      if (health != m_faceHealth.end() && isUnhealthy(health->second))
+        {
+          // no further trials until this one is answered, has timed out
+          // or its Interest is satisfied by another face
+          health->second.isTrialPending = true;
+          health->second.retryAfter = now + health->second.backoff;
+          ++m_nTrials;
+        }
+
+      if (m_recorder != nullptr)
+        m_recorder->recordForward(*face);
+
+      ++m_nUpstreamInterests;
+      this->sendInterest(pitEntry, face);
+    }
+}
+
+std::vector<shared_ptr<Face>>
+RandomLoadBalancerStrategy::selectFaces(const fib::NextHopList& nexthops,
+                                        shared_ptr<pit::Entry>& pitEntry,
+                                        bool isBackingOffSkipped)
+{
+  std::vector<shared_ptr<Face>> selected;
+  selected.reserve(std::min(m_nReplicas, nexthops.size()));
+
+  const auto now = time::steady_clock::now();
+  size_t nEligible = 0;
+  for (const auto& nexthop : nexthops)
+    {
+      if (!canForwardToNextHop(pitEntry, nexthop))
+        continue;
+
+      if (isBackingOffSkipped && !m_faceHealth.empty())
+        {
+          auto health = m_faceHealth.find(nexthop.getFace()->getId());
+          if (health != m_faceHealth.end() && isUnhealthy(health->second) &&
+              (health->second.isTrialPending || now < health->second.retryAfter))
+            continue;
+        }
+
+      // the n-th eligible face replaces a random one of the k with probability k/n
+      if (nEligible < m_nReplicas)
+        {
+          selected.push_back(nexthop.getFace());
+        }
+      else
+        {
+          boost::random::uniform_int_distribution<size_t> dist(0, nEligible);
+          const size_t slot = dist(m_randomGenerator);
+          if (slot < m_nReplicas)
+            selected[slot] = nexthop.getFace();
+        }
+      ++nEligible;
+    }
+
+  return selected;
+}
+
+void
+RandomLoadBalancerStrategy::beforeSatisfyInterest(shared_ptr<pit::Entry> pitEntry,
+                                                  const Face& inFace,
+                                                  const Data& data)
+{
+  if (m_recorder != nullptr)
+    m_recorder->recordData(inFace, *pitEntry, data);
+
+  auto health = m_faceHealth.find(inFace.getId());
+  if (health != m_faceHealth.end())
+    {
+      // healthy again; with history, the entry holds the face's counters
+      shared_ptr<StrategyHistory::FaceCounters> history = std::move(health->second.history);
+      if (history == nullptr)
+        {
+          m_faceHealth.erase(health);
+        }
+      else
+        {
+          health->second = FaceHealth();
+          health->second.history = std::move(history);
+        }
+    }
+  endTrials(*pitEntry, inFace.getId());
+
+  if (m_sharedFaces != nullptr)
+    {
+      for (const auto& outRecord : pitEntry->getOutRecords())
+        {
+          if (outRecord.getFace()->getId() == inFace.getId())
+            m_sharedFaces->recordRtt(inFace, time::duration_cast<time::microseconds>(
+                                               time::steady_clock::now() -
+                                               outRecord.getLastRenewed()));
+        }
+    }
+
+  auto pitEntryInfo = pitEntry->getStrategyInfo<RandomPitInfo>();
+  if (m_history != nullptr && pitEntryInfo != nullptr)
+    {
+      auto inFlight = std::find_if(pitEntryInfo->inFlight.begin(), pitEntryInfo->inFlight.end(),
+                                   [&inFace] (const StrategyHistory::InFlight& entry) {
+                                     return entry.getFaceId() == inFace.getId();
+                                   });
+      if (inFlight != pitEntryInfo->inFlight.end())
+        {
+          StrategyHistory::countData(inFlight->getCounters(),
+                                     time::steady_clock::now() - inFlight->getSendTime());
+        }
+      else
+        {
+          // answered by a face of an earlier transmission
+          for (const auto& outRecord : pitEntry->getOutRecords())
+            {
+              if (outRecord.getFace()->getId() == inFace.getId())
+                StrategyHistory::countData(*m_history->getCounters(inFace.getId()),
+                                           time::steady_clock::now() -
+                                           outRecord.getLastRenewed());
+            }
+        }
+      pitEntryInfo->inFlight.clear();
+    }
+}
+
+void
+RandomLoadBalancerStrategy::beforeExpirePendingInterest(shared_ptr<pit::Entry> pitEntry)
+{
+  if (m_recorder != nullptr)
+    m_recorder->recordExpire(*pitEntry);
+
+  for (const auto& outRecord : pitEntry->getOutRecords())
+    {
+      onFaceTimeout(outRecord.getFace()->getId());
+
+      if (m_sharedFaces != nullptr)
+        m_sharedFaces->recordFailure(*outRecord.getFace());
+
+      if (m_history != nullptr)
+        ++m_history->getCounters(outRecord.getFace()->getId())->nTimeouts;
+    }
+
+  auto pitEntryInfo = pitEntry->getStrategyInfo<RandomPitInfo>();
+  if (pitEntryInfo != nullptr)
+    pitEntryInfo->inFlight.clear();
+}
+
+void
+RandomLoadBalancerStrategy::onFaceTimeout(FaceId faceId)
+{
+  FaceHealth& health = m_faceHealth[faceId];
+  ++health.nConsecutiveTimeouts;
+
+  if (health.nConsecutiveTimeouts == UNHEALTHY_TIMEOUTS)
+    {
+      health.backoff = INITIAL_BACKOFF;
+    }
+  else if (isUnhealthy(health) && health.isTrialPending)
+    {
+      // the trial failed, most likely
+      health.backoff = std::min(health.backoff * 2, MAX_BACKOFF);
+      health.isTrialPending = false;
+    }
+  else
+    {
+      // Interests sent before the face became unhealthy
+      return;
+    }
+
+  if (m_history != nullptr)
+    ++m_history->getCounters(faceId)->nDemotions;
+
+  health.retryAfter = time::steady_clock::now() + health.backoff;
+}
+
+void
+RandomLoadBalancerStrategy::endTrials(const pit::Entry& pitEntry, FaceId answeredFaceId)
+{
+  if (m_faceHealth.empty())
+    return;
+
+  for (const auto& outRecord : pitEntry.getOutRecords())
     {
-      boost::random::uniform_int_distribution<> dist(0, nexthops.size() - 1);
-      const size_t randomIndex = dist(m_randomGenerator);
+      const FaceId faceId = outRecord.getFace()->getId();
+      if (faceId == answeredFaceId)
+        continue;
 
-      uint64_t currentIndex = 0;
+      // a later timeout of this face must not count as a failed trial
+      auto health = m_faceHealth.find(faceId);
+      if (health != m_faceHealth.end())
+        health->second.isTrialPending = false;
+    }
+}
 
-      for (selected = nexthops.begin();
-           selected != nexthops.end() && currentIndex != randomIndex;
-           ++selected, ++currentIndex)
-        { }
-    } while (!canForwardToNextHop(pitEntry, *selected));
+bool
+RandomLoadBalancerStrategy::hasHealthyFace(const fib::NextHopList& nexthops) const
+{
+  return std::any_of(nexthops.begin(), nexthops.end(),
+                     [this] (const fib::NextHop& hop) {
+                       auto it = m_faceHealth.find(hop.getFace()->getId());
+                       if (it != m_faceHealth.end() && isUnhealthy(it->second))
+                         return false;
 
-  this->sendInterest(pitEntry, selected->getFace());
+                       SharedFaceTable::Snapshot snapshot;
+                       return m_sharedFaces == nullptr ||
+                              !m_sharedFaces->read(*hop.getFace(), snapshot) ||
+                              snapshot.nConsecutiveFailures < UNHEALTHY_TIMEOUTS;
+                     });
+}
+
+void
+RandomLoadBalancerStrategy::writeStats(std::ostream& os)
+{
+  os << "{\"replicas\": " << m_nReplicas
+     << ", \"interests\": " << m_nInterests
+     << ", \"upstream_interests\": " << m_nUpstreamInterests
+     << ", \"retry_budget\": ";
+  m_retryBudget.writeJson(os);
+  os << ", \"shedding\": ";
+  m_loadShedder.writeJson(os, m_pit.size(), *m_nPendingInterests);
+
+  os << ", \"trials\": " << m_nTrials << ", \"faces\": {";
+  bool isFirst = true;
+  for (auto it = m_faceHealth.begin(); it != m_faceHealth.end(); ++it)
+    {
+      // entries kept only for their history counters
+      if (it->second.nConsecutiveTimeouts == 0)
+        continue;
+
+      os << (isFirst ? "" : ", ") << "\"" << it->first << "\": "
+         << "{\"timeouts\": " << it->second.nConsecutiveTimeouts
+         << ", \"healthy\": " << (isUnhealthy(it->second) ? "false" : "true")
+         << ", \"backoff_ms\": " << it->second.backoff.count() << "}";
+      isFirst = false;
+    }
+  os << "}}";
 }
 
 } // namespace fw
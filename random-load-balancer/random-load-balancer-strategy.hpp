@@ -27,13 +27,42 @@
 #ifndef NFD_DAEMON_FW_SIMPLE_LOAD_BALANCER_STRATEGY_HPP
 #define NFD_DAEMON_FW_SIMPLE_LOAD_BALANCER_STRATEGY_HPP
 
+#include <unordered_map>
+
 #include <boost/random/mersenne_twister.hpp>
 
 #include "strategy.hpp"
+#include "strategy-recorder.hpp"
+#include "strategy-parameters.hpp"
+#include "strategy-history.hpp"
+#include "retry-budget.hpp"
+#include "load-shedder.hpp"
+#include "shared-face-table.hpp"
+#include "strategy-control.hpp"
 
 namespace nfd {
 namespace fw {
 
+/** \brief PIT entry info of the random load balancer
+ */
+class RandomPitInfo : public StrategyInfo
+{
+public:
+  explicit
+  RandomPitInfo(const shared_ptr<size_t>& nPendingInterests)
+    : pending(nPendingInterests)
+  {
+  }
+
+  static int constexpr
+  getTypeId() { return 9972; }
+
+  /// counts the entry among the strategy's pending Interests
+  PendingInterestToken pending;
+
+  /// counts the entry in flight to the faces it was last sent to, with history
+  std::vector<StrategyHistory::InFlight> inFlight;
+};
 
 class RandomLoadBalancerStrategy : public Strategy
 {
@@ -49,11 +78,135 @@ public:
                        shared_ptr<fib::Entry> fibEntry,
                        shared_ptr<pit::Entry> pitEntry);
 
+  virtual void
+  beforeSatisfyInterest(shared_ptr<pit::Entry> pitEntry,
+                        const Face& inFace,
+                        const Data& data);
+
+  virtual void
+  beforeExpirePendingInterest(shared_ptr<pit::Entry> pitEntry);
+
+protected:
+  /** \brief reply to the "stats" control command
+   */
+  void
+  writeStats(std::ostream& os);
+
+  /** \brief apply the settings of \p parameters that can change while the
+   *         strategy runs, after parsing all of them
+   *  \param isDryRun only parse the values
+   *  \throw StrategyParameters::Error a value is invalid; nothing changed
+   */
+  void
+  configure(const StrategyParameters& parameters, bool isDryRun = false);
+
+  /** \brief check the "set KEY=VALUE..." control command, see
+   *         WeightedLoadBalancerStrategy::reconfigure
+   */
+  StrategyControl::Action
+  reconfigure(const std::vector<std::string>& arguments, std::vector<std::string>& accepted);
+
+  /** \brief check StrategyConfig::RELOAD_COMMAND, see
+   *         WeightedLoadBalancerStrategy::reloadDefaults
+   */
+  StrategyControl::Action
+  reloadDefaults(std::vector<std::string>& changed);
+
+  StrategyControl::Action
+  prepareParameters(const StrategyParameters& parameters);
+
+  /** \brief pick up to m_nReplicas distinct eligible nexthops uniformly
+   *
+   *  One pass of reservoir sampling, so ineligible faces cost nothing
+   *  extra and no draw is ever rejected.  With \p isBackingOffSkipped,
+   *  unhealthy faces are only eligible once their back-off is over and
+   *  their last trial is answered or has timed out.
+   */
+  std::vector<shared_ptr<Face>>
+  selectFaces(const fib::NextHopList& nexthops, shared_ptr<pit::Entry>& pitEntry,
+              bool isBackingOffSkipped);
+
+  /** \brief per-face health, kept only for faces that timed out since
+   *         their last Data, or with history for every face sent to
+   */
+  struct FaceHealth
+  {
+    uint32_t nConsecutiveTimeouts = 0;
+
+    /// whether an unhealthy face has a trial Interest out
+    bool isTrialPending = false;
+
+    time::milliseconds backoff = time::milliseconds::zero();
+
+    /// an unhealthy face gets a trial Interest from then on
+    time::steady_clock::TimePoint retryAfter;
+
+    /// the face's history counters, taken when it is first sent to
+    shared_ptr<StrategyHistory::FaceCounters> history;
+  };
+
+  static bool
+  isUnhealthy(const FaceHealth& health)
+  {
+    return health.nConsecutiveTimeouts >= UNHEALTHY_TIMEOUTS;
+  }
+
+  void
+  onFaceTimeout(FaceId faceId);
+
+  /** \brief clear the pending trials of the faces \p pitEntry went to,
+   *         other than \p answeredFaceId, as the entry ends without
+   *         their answer
+   */
+  void
+  endTrials(const pit::Entry& pitEntry, FaceId answeredFaceId);
+
+  /** \return whether some nexthop has not timed out
+   *          UNHEALTHY_TIMEOUTS times in a row, here or, with a shared
+   *          table, in another process
+   */
+  bool
+  hasHealthyFace(const fib::NextHopList& nexthops) const;
+
 public:
   static const Name STRATEGY_NAME;
 
+  /// parameters the "set" control command may change
+  static const std::set<std::string> LIVE_PARAMETERS;
+
+  static const uint32_t UNHEALTHY_TIMEOUTS;
+  static const time::milliseconds INITIAL_BACKOFF;
+  static const time::milliseconds MAX_BACKOFF;
+
 protected:
+  /// as given to the constructor, with the changes of "set"
+  StrategyParameters m_parameters;
+
   boost::random::mt19937 m_randomGenerator;
+
+  /// faces each Interest goes to, set by the replicas=K parameter
+  size_t m_nReplicas;
+  uint64_t m_nInterests;
+  uint64_t m_nUpstreamInterests;
+  RetryBudget m_retryBudget;
+  LoadShedder m_loadShedder;
+
+  /// PIT entries of this instance, see PendingInterestToken
+  shared_ptr<size_t> m_nPendingInterests;
+  const Pit& m_pit;
+
+  std::unordered_map<FaceId, FaceHealth> m_faceHealth;
+  signal::ScopedConnection m_afterFaceRemove;
+  uint64_t m_nTrials;
+
+  /// set by the shared-table=PATH parameter
+  shared_ptr<SharedFaceTable> m_sharedFaces;
+
+  /// set by the record=PATH parameter
+  unique_ptr<StrategyRecorder> m_recorder;
+
+  /// set by the history=MINUTES parameter
+  unique_ptr<StrategyHistory> m_history;
 };
 
 } // namespace fw
@@ -24,6 +24,8 @@
 # @author Susmit Shannigrahi <http://www.cs.colostate.edu/~susmit>
 # pylint: disable=line-too-long
 
+from __future__ import print_function
+
 import sys
 import time
 import argparse
@@ -33,6 +35,7 @@ from pyndn import Interest
 from pyndn import Name
 from pyndn import Face
 
+from loadgen import parseStamp
 
 class Consumer(object):
     '''Sends Interest, listens for data'''
@@ -51,23 +54,32 @@ class Consumer(object):
             interest.setInterestLifetimeMilliseconds(4000)
             interest.setMustBeFresh(True)
 
+            self.sendTime = time.time()
             self.face.expressInterest(interest, self._onData, self._onTimeout)
 
             while not self.isDone:
                 self.face.processEvents()
                 time.sleep(0.01)
 
-            print "Sent Interest for %s" % uri
+            print("Sent Interest for %s" % uri)
 
         except RuntimeError as e:
-            print "ERROR: %s" % e
+            print("ERROR: %s" % e)
 
 
     def _onData(self, interest, data):
         payload = data.getContent()
         name = data.getName()
 
-        print "Received data: %s\n" % payload.toRawStr()
+        latency = (time.time() - self.sendTime) * 1000.0
+
+        stamp = parseStamp(data)
+        if stamp is None:
+            print("Received data: %s\n" % payload.toRawStr())
+        else:
+            print("Received data: %s" % stamp["payload"])
+            print("Served by %s in %.1f ms (%.1f ms at the producer)\n"
+                  % (stamp["producer"], latency, (stamp["sent"] - stamp["received"]) * 1000.0))
         self.isDone = True
 
 
@@ -75,7 +87,7 @@ class Consumer(object):
         name = interest.getName()
         uri = name.toUri()
 
-        print "TIMEOUT ", uri
+        print("TIMEOUT ", uri)
         self.isDone = True
 
 
@@ -92,5 +104,5 @@ if __name__ == "__main__":
 
     except:
         traceback.print_exc(file=sys.stdout)
-        print "Error parsing command line arguments"
+        print("Error parsing command line arguments")
         sys.exit(1)
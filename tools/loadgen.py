@@ -0,0 +1,255 @@
+# -*- Mode:python; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+#
+# Copyright (c) 2014 Susmit Shannigrahi, Steve DiBenedetto
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+# A copy of the GNU General Public License is in the file COPYING.
+
+'''Interest load generator reporting throughput and latency as JSON.
+
+Two load modes are supported:
+
+* open:   Interests are sent at a fixed rate regardless of responses
+* closed: a fixed window of Interests is kept outstanding
+
+In open mode a surge (START:END:RATE) replaces the rate for part of the
+run, e.g. to model a flash crowd.  With samples enabled the report lists
+every Interest as [send time, latency] in seconds since the start and
+milliseconds, with a null latency for timeouts.
+
+Every Interest carries a unique name under the given prefix so that
+responses never come from a Content Store.  Data stamped by
+tools/producer.py is attributed to the producer that served it, so the
+report also shows the realised traffic split and per-path latency.
+'''
+
+from __future__ import print_function
+
+import sys
+import json
+import time
+import random
+import argparse
+import traceback
+
+from pyndn import Interest
+from pyndn import Name
+from pyndn import Face
+
+
+def percentile(sortedValues, fraction):
+    '''Nearest-rank percentile of an already sorted list'''
+    if not sortedValues:
+        return None
+    index = int(round(fraction * (len(sortedValues) - 1)))
+    return sortedValues[index]
+
+
+def parseStamp(data):
+    '''Producer ID and timestamps stamped into Data by tools/producer.py
+
+    Returns None for Data that does not carry a stamp.
+    '''
+    try:
+        content = json.loads(data.getContent().toRawStr())
+        return content if "producer" in content else None
+    except (ValueError, TypeError):
+        return None
+
+
+def summarizeLatencies(latencies):
+    values = sorted(latencies)
+    if not values:
+        return {"count": 0}
+
+    return {
+        "count": len(values),
+        "mean": sum(values) / len(values),
+        "p50": percentile(values, 0.50),
+        "p90": percentile(values, 0.90),
+        "p99": percentile(values, 0.99),
+        "max": values[-1],
+    }
+
+
+class LoadGenerator(object):
+    '''Expresses Interests for a fixed duration and records the outcome'''
+
+    def __init__(self, prefix, duration, mode="open", rate=100.0, window=10,
+                 lifetime=4000, surge=None, keepSamples=False):
+        self.prefix = Name(prefix)
+        self.duration = duration
+        self.mode = mode
+        self.rate = rate
+        self.window = window
+        self.lifetime = lifetime
+        self.surge = surge
+        self.keepSamples = keepSamples
+        self.samples = []
+        self.owed = 1.0
+        self.lastElapsed = 0.0
+
+        self.face = Face()
+        self.runId = "%08x" % random.getrandbits(32)
+
+        self.nSent = 0
+        self.nData = 0
+        self.nTimeouts = 0
+        self.sendTimes = {}
+        self.latencies = []
+
+        # producer ID -> {"latencies": [...], "residence": [...]}
+        self.producers = {}
+
+
+    def run(self):
+        startTime = time.time()
+        endTime = startTime + self.duration
+        self.startTime = startTime
+
+        while True:
+            now = time.time()
+            if now < endTime:
+                self._sendDue(now - startTime)
+            elif not self.sendTimes:
+                break
+
+            self.face.processEvents()
+            time.sleep(0.001)
+
+        return self.report(time.time() - startTime)
+
+
+    def _sendDue(self, elapsed):
+        if self.mode == "closed":
+            while len(self.sendTimes) < self.window:
+                self._express()
+        else:
+            self.owed += (elapsed - self.lastElapsed) * self._rateAt(elapsed)
+            self.lastElapsed = elapsed
+            while self.owed >= 1.0:
+                self.owed -= 1.0
+                self._express()
+
+
+    def _rateAt(self, elapsed):
+        if self.surge is not None and self.surge[0] <= elapsed < self.surge[1]:
+            return self.surge[2]
+        return self.rate
+
+
+    def _express(self):
+        name = Name(self.prefix)
+        name.append(self.runId).append(str(self.nSent))
+
+        interest = Interest(name)
+        interest.setInterestLifetimeMilliseconds(self.lifetime)
+        interest.setMustBeFresh(True)
+
+        self.sendTimes[name.toUri()] = time.time()
+        self.nSent += 1
+        self.face.expressInterest(interest, self._onData, self._onTimeout)
+
+
+    def _onData(self, interest, data):
+        sent = self.sendTimes.pop(interest.getName().toUri(), None)
+        if sent is None:
+            return
+
+        latency = (time.time() - sent) * 1000.0
+        self.nData += 1
+        self.latencies.append(latency)
+        if self.keepSamples:
+            self.samples.append([sent - self.startTime, latency])
+
+        stamp = parseStamp(data)
+        producerId = stamp["producer"] if stamp is not None else "unknown"
+        producer = self.producers.setdefault(producerId, {"latencies": [], "residence": []})
+        producer["latencies"].append(latency)
+        if stamp is not None:
+            producer["residence"].append((stamp["sent"] - stamp["received"]) * 1000.0)
+
+
+    def _onTimeout(self, interest):
+        sent = self.sendTimes.pop(interest.getName().toUri(), None)
+        if sent is None:
+            return
+
+        self.nTimeouts += 1
+        if self.keepSamples:
+            self.samples.append([sent - self.startTime, None])
+
+
+    def report(self, elapsed):
+        producers = {}
+        for producerId, producer in self.producers.items():
+            producers[producerId] = {
+                "data": len(producer["latencies"]),
+                "share": float(len(producer["latencies"])) / self.nData,
+                "latency_ms": summarizeLatencies(producer["latencies"]),
+                "residence_ms": summarizeLatencies(producer["residence"]),
+            }
+
+        result = {
+            "mode": self.mode,
+            "duration": elapsed,
+            "interests": self.nSent,
+            "data": self.nData,
+            "timeouts": self.nTimeouts,
+            "satisfaction": float(self.nData) / self.nSent if self.nSent else 0.0,
+            "throughput": self.nData / elapsed if elapsed > 0 else 0.0,
+            "latency_ms": summarizeLatencies(self.latencies),
+            "producers": producers,
+        }
+        if self.keepSamples:
+            result["samples"] = sorted(self.samples, key=lambda sample: sample[0])
+        return result
+
+
+def parseSurge(text):
+    '''Parse a START:END:RATE surge (seconds, seconds, Interests/s)'''
+    start, end, rate = text.split(":")
+    return (float(start), float(end), float(rate))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Generate Interest load and report throughput and latency')
+    parser.add_argument("-n", "--name", required=True, help='prefix under which Interests are expressed')
+    parser.add_argument("-t", "--duration", type=float, default=10.0, help='seconds to generate load for')
+    parser.add_argument("-m", "--mode", choices=["open", "closed"], default="open", help='fixed rate or fixed window')
+    parser.add_argument("-r", "--rate", type=float, default=100.0, help='Interests per second in open mode')
+    parser.add_argument("-w", "--window", type=int, default=10, help='outstanding Interests in closed mode')
+    parser.add_argument("-l", "--lifetime", type=int, default=4000, help='Interest lifetime in milliseconds')
+    parser.add_argument("-s", "--surge", type=parseSurge, default=None, help='START:END:RATE rate override in open mode')
+    parser.add_argument("--samples", action="store_true", help='include every Interest outcome in the report')
+    parser.add_argument("-o", "--output", default=None, help='write the JSON report to this file instead of stdout')
+
+    args = parser.parse_args()
+
+    try:
+        generator = LoadGenerator(args.name, args.duration, args.mode,
+                                  args.rate, args.window, args.lifetime, args.surge,
+                                  args.samples)
+        result = generator.run()
+
+        if args.output is None:
+            json.dump(result, sys.stdout, indent=2, sort_keys=True)
+            print()
+        else:
+            with open(args.output, "w") as output:
+                json.dump(result, output, indent=2, sort_keys=True)
+
+    except:
+        traceback.print_exc(file=sys.stdout)
+        sys.exit(1)
@@ -0,0 +1,129 @@
+# -*- Mode:python; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+#
+# Copyright (c) 2014 Susmit Shannigrahi, Steve DiBenedetto
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+# A copy of the GNU General Public License is in the file COPYING.
+
+'''Performance regression gate for the strategies.
+
+Runs the strategy microbenchmark and simulation programs (see
+benchmarks/), compares every metric with benchmarks/baseline.json and
+exits with status 1 when any metric regresses by more than its
+tolerance.  Metrics are lower-is-better unless the baseline marks them
+"better": "higher".  A metric without a baseline value fails the gate
+too, until --update records one.
+'''
+
+from __future__ import print_function
+
+import os
+import sys
+import json
+import argparse
+import subprocess
+
+REPO_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_BASELINE = os.path.join(REPO_DIR, "benchmarks", "baseline.json")
+PROGRAMS = ["strategy-benchmark", "strategy-simulation"]
+
+
+def collectResults(buildDir):
+    metrics = {}
+    for program in PROGRAMS:
+        output = subprocess.check_output([os.path.join(buildDir, program)]).decode()
+        metrics.update(json.loads(output)["metrics"])
+    return metrics
+
+
+def compare(baseline, results):
+    '''Return one row per baseline metric: (name, base, current, change, status)'''
+    defaultTolerance = baseline.get("tolerance", 0.1)
+    rows = []
+
+    for name in sorted(baseline["metrics"]):
+        spec = baseline["metrics"][name]
+        base = spec.get("value")
+        current = results.get(name)
+
+        if current is None:
+            rows.append((name, base, None, None, "MISSING"))
+            continue
+        if base is None:
+            rows.append((name, None, current, None, "UNSET"))
+            continue
+
+        change = (current - base) / abs(base) if base else (0.0 if current == base else float("inf"))
+        worse = -change if spec.get("better", "lower") == "higher" else change
+        tolerance = spec.get("tolerance", defaultTolerance)
+        rows.append((name, base, current, change, "REGRESSED" if worse > tolerance else "ok"))
+
+    return rows
+
+
+def formatValue(value):
+    return "-" if value is None else "%.4g" % value
+
+
+def printRows(rows):
+    width = max([len(row[0]) for row in rows] + [6])
+    print("%-*s %12s %12s %9s  %s" % (width, "metric", "baseline", "current", "change", "status"))
+    for name, base, current, change, status in rows:
+        print("%-*s %12s %12s %9s  %s" % (width, name, formatValue(base), formatValue(current),
+                                          "-" if change is None else "%+.1f%%" % (100 * change),
+                                          status))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Compare strategy benchmark results with the checked-in baseline')
+    parser.add_argument("-b", "--build-dir", default="build", help='directory holding the benchmark programs')
+    parser.add_argument("-r", "--results", default=None, help='use this results JSON instead of running the programs')
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE, help='baseline file to compare with')
+    parser.add_argument("--update", action="store_true", help='record the current results as the new baseline')
+    parser.add_argument("--strict", action="store_true", help='also fail on metrics without a baseline value')
+
+    args = parser.parse_args()
+
+    with open(args.baseline) as baselineFile:
+        baseline = json.load(baselineFile)
+
+    if args.results is not None:
+        with open(args.results) as resultsFile:
+            results = json.load(resultsFile)["metrics"]
+    else:
+        results = collectResults(args.build_dir)
+
+    if args.update:
+        for name, spec in baseline["metrics"].items():
+            if name in results:
+                spec["value"] = results[name]
+        with open(args.baseline, "w") as baselineFile:
+            json.dump(baseline, baselineFile, indent=2, sort_keys=True)
+            baselineFile.write("\n")
+        print("baseline updated: %s" % args.baseline)
+        sys.exit(0)
+
+    rows = compare(baseline, results)
+    printRows(rows)
+
+    unset = [row for row in rows if row[4] == "UNSET"]
+    if unset:
+        print("\nwarning: %d metric(s) without a baseline value, not checked; record them with --update"
+              % len(unset), file=sys.stderr)
+
+    failed = [row for row in rows if row[4] in ("REGRESSED", "MISSING") or
+              (args.strict and row[4] == "UNSET")]
+    if failed:
+        print("\n%d metric(s) regressed, missing or without a baseline value" % len(failed))
+        sys.exit(1)
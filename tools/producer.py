@@ -21,11 +21,17 @@
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 # A copy of the GNU General Public License is in the file COPYING.
 
+from __future__ import print_function
+
 import sys
 import time
 import argparse
 import traceback
 import random
+import heapq
+import json
+import socket
+import os
 
 from threading import Thread
 
@@ -38,32 +44,76 @@ from pyndn.security import KeyChain
 stopServing = False
 
 class ConsoleThread(Thread):
-    def __init__(self):
+    '''Reads commands from stdin
+
+    q          stop serving
+    slow F     multiply the configured delay by F
+    loss P     drop each Interest with probability P
+    normal     undo slow and loss
+    '''
+
+    def __init__(self, producer):
         Thread.__init__(self)
+        self.daemon = True
+        self.producer = producer
 
     def run(self):
         global stopServing
 
         while True:
             line = sys.stdin.readline()
-            if "q" in line:
-                print "stopping data service"
+            if not line:
+                # stdin closed, only a signal can stop the producer now
+                return
+
+            words = line.split()
+            if not words:
+                continue
+
+            if words[0].startswith("q"):
+                print("stopping data service")
                 stopServing = True
                 return
+            elif words[0] == "slow" and len(words) == 2:
+                self.producer.slowdown = float(words[1])
+            elif words[0] == "loss" and len(words) == 2:
+                self.producer.loss = float(words[1])
+            elif words[0] == "normal":
+                self.producer.slowdown = 1.0
+                self.producer.loss = 0.0
+            else:
+                print("unknown command: %s" % line.strip())
+                continue
+
+            print("now serving with slowdown %g, loss %g"
+                  % (self.producer.slowdown, self.producer.loss))
 
 
 
 class Producer(object):
-    def __init__(self, delay=None):
+    '''Answers Interests after a fixed delay, serving at most capacity Data per second'''
+
+    def __init__(self, delay=None, capacity=None, producerId=None):
         self.delay = delay
+        self.capacity = capacity
+        self.producerId = producerId or "%s-%d" % (socket.gethostname(), os.getpid())
         self.nDataServed = 0
         self.isDone = False
 
+        # fault injection, changed at runtime through the console
+        self.slowdown = 1.0
+        self.loss = 0.0
+
+        # replies waiting for their departure time, as (time, seq, name, arrival, transport)
+        self.pendingReplies = []
+        self.nextFreeTime = 0.0
+        self.replySeq = 0
+
 
     def run(self, prefix):
         self.keyChain = KeyChain()
 
-        self.consoleThread = ConsoleThread()
+        self.consoleThread = ConsoleThread(self)
         self.consoleThread.start()
 
         # The default Face will connect using a Unix socket
@@ -76,11 +126,16 @@ class Producer(object):
         # Also use the default certificate name to sign data packets.
         face.registerPrefix(prefix, self.onInterest, self.onRegisterFailed)
 
-        print "Registering prefix", prefix.toUri()
+        print("Registering prefix", prefix.toUri())
 
         while not self.isDone:
             face.processEvents()
-            time.sleep(0.01)
+            self._sendDueReplies()
+
+            if self.pendingReplies:
+                time.sleep(0.001)
+            else:
+                time.sleep(0.01)
 
 
 
@@ -88,18 +143,49 @@ class Producer(object):
         global stopServing
 
         if stopServing:
-            print "refusing to serve " + interest.getName().toUri()
+            print("refusing to serve " + interest.getName().toUri())
             self.consoleThread.join()
-            print "join'd thread"
+            print("join'd thread")
+            return
+
+        if self.loss > 0 and random.random() < self.loss:
             return
 
+        # Model a single server: each reply occupies the producer for
+        # 1/capacity seconds, then travels for the configured delay.
+        now = time.time()
+        departure = now
+        if self.capacity is not None:
+            self.nextFreeTime = max(now, self.nextFreeTime) + 1.0 / self.capacity
+            departure = self.nextFreeTime
         if self.delay is not None:
-            time.sleep(self.delay)
+            departure += self.delay * self.slowdown
+
+        self.replySeq += 1
+        heapq.heappush(self.pendingReplies,
+                       (departure, self.replySeq, interest.getName(), now, transport))
+
+
+    def _sendDueReplies(self):
+        now = time.time()
+        while self.pendingReplies and self.pendingReplies[0][0] <= now:
+            _, _, interestName, arrival, transport = heapq.heappop(self.pendingReplies)
+            self._reply(interestName, arrival, transport)
+
 
-        interestName = interest.getName()
+    def _reply(self, interestName, arrival, transport):
+        # Stamp who served the Interest and when, so consumers can
+        # attribute each Data to an upstream (timestamps are seconds
+        # since the epoch on the producer's clock)
+        content = {
+            "producer": self.producerId,
+            "received": arrival,
+            "sent": time.time(),
+            "payload": "Hello " + interestName.toUri(),
+        }
 
         data = Data(interestName)
-        data.setContent("Hello " + interestName.toUri())
+        data.setContent(json.dumps(content, sort_keys=True))
         data.getMetaInfo().setFreshnessPeriod(3600 * 1000)
 
         self.keyChain.sign(data, self.keyChain.getDefaultCertificateName())
@@ -107,24 +193,27 @@ class Producer(object):
         transport.send(data.wireEncode().toBuffer())
 
         self.nDataServed += 1
-        print "Replied to: %s (#%d)" % (interestName.toUri(), self.nDataServed)
+        print("Replied to: %s (#%d)" % (interestName.toUri(), self.nDataServed))
 
 
     def onRegisterFailed(self, prefix):
-        print "Register failed for prefix", prefix.toUri()
+        print("Register failed for prefix", prefix.toUri())
 
 if __name__ == '__main__':
     parser = argparse.ArgumentParser(description='Parse command line args for ndn producer')
     parser.add_argument("-n", "--namespace", required=True, help='namespace to listen under')
-    parser.add_argument("-d", "--delay", required=False, help='namespace to listen under', nargs= '?', const=1, type=float, default=None)
+    parser.add_argument("-d", "--delay", required=False, help='seconds to hold each reply before sending it', nargs= '?', const=1, type=float, default=None)
+    parser.add_argument("-c", "--capacity", required=False, help='maximum Data packets served per second', type=float, default=None)
+    parser.add_argument("-i", "--id", required=False, help='producer ID stamped into every Data (default: host-pid)', default=None)
 
     args = parser.parse_args()
 
     try:
         namespace = args.namespace
         delay = args.delay
+        capacity = args.capacity
 
-        Producer(delay).run(namespace)
+        Producer(delay, capacity, args.id).run(namespace)
 
     except:
         traceback.print_exc(file=sys.stdout)
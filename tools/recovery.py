@@ -0,0 +1,195 @@
+# -*- Mode:python; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+#
+# Copyright (c) 2014 Susmit Shannigrahi, Steve DiBenedetto
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+# A copy of the GNU General Public License is in the file COPYING.
+
+'''Failure-recovery suite for the strategies.
+
+Injects a fault into one of three upstreams (face down, 10x slowdown,
+30% loss, flapping) and reports, per strategy, the time until the
+satisfaction ratio and p99 latency are back at their pre-fault baseline
+and the number of Interests lost after the fault.  Results come from the
+simulator (benchmarks/strategy-recovery) and optionally from the local
+testbed, where the same windowing is applied to the load generator's
+per-Interest samples.
+'''
+
+from __future__ import print_function
+
+import os
+import sys
+import json
+import argparse
+import subprocess
+import traceback
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+
+FAULTS = ["face-down", "slowdown", "loss", "flapping"]
+COLUMNS = ["recovery_ms", "interests_lost", "baseline_satisfaction", "baseline_p99_ms"]
+
+# seconds of load before the fault, and the testbed --fault action reproducing it
+FAULT_AT = 10.0
+TESTBED_FAULTS = {
+    "face-down": "kill",
+    "slowdown": "slow=10",
+    "loss": "loss=0.3",
+    "flapping": "flap=1",
+}
+TESTBED_STRATEGIES = ["weighted-load-balancer", "random-load-balancer"]
+
+WARMUP = 2.0
+WINDOW = 0.25
+SATISFACTION_TOLERANCE = 0.01
+P99_TOLERANCE = 0.2
+
+
+class Window(object):
+    def __init__(self):
+        self.nSatisfied = 0
+        self.nTimeouts = 0
+        self.latencies = []
+
+    def add(self, latency):
+        if latency is None:
+            self.nTimeouts += 1
+        else:
+            self.nSatisfied += 1
+            self.latencies.append(latency)
+
+    def satisfaction(self):
+        total = self.nSatisfied + self.nTimeouts
+        return float(self.nSatisfied) / total if total else 1.0
+
+    def p99(self):
+        if not self.latencies:
+            return 0.0
+        values = sorted(self.latencies)
+        return values[int(round(0.99 * (len(values) - 1)))]
+
+
+def computeRecovery(samples, faultAt):
+    '''Same definition as benchmarks/strategy-recovery.cpp, in seconds'''
+    baseline = Window()
+    windows = {}
+    lost = 0
+
+    for sent, latency in samples:
+        if WARMUP <= sent < faultAt:
+            baseline.add(latency)
+        elif sent >= faultAt:
+            windows.setdefault(int((sent - faultAt) / WINDOW), Window()).add(latency)
+            if latency is None:
+                lost += 1
+
+    baseSatisfaction = baseline.satisfaction()
+    baseP99 = baseline.p99()
+
+    recovery = 0.0
+    for index in sorted(windows):
+        window = windows[index]
+        if (window.satisfaction() < baseSatisfaction - SATISFACTION_TOLERANCE or
+                window.p99() > baseP99 * (1 + P99_TOLERANCE)):
+            recovery = (index + 1) * WINDOW
+
+    if windows and recovery >= (max(windows) + 1) * WINDOW:
+        recovery = -1.0
+
+    return {
+        "recovery_ms": recovery * 1000.0 if recovery >= 0 else -1.0,
+        "interests_lost": lost,
+        "baseline_satisfaction": baseSatisfaction,
+        "baseline_p99_ms": baseP99,
+    }
+
+
+def fromSimulation(metrics):
+    results = {}
+    for name, value in metrics.items():
+        strategy, fault, metric = name.split("/")
+        results.setdefault(fault, {}).setdefault(strategy, {})[metric] = value
+    return results
+
+
+def runTestbed(strategy, fault, duration):
+    command = [sys.executable, os.path.join(TOOLS_DIR, "testbed.py"),
+               "-s", strategy, "-t", str(duration), "--samples",
+               "-p", "0.01", "-p", "0.02", "-p", "0.03", "-r", "300",
+               "--fault", "0@%g:%s" % (FAULT_AT, TESTBED_FAULTS[fault])]
+    report = json.loads(subprocess.check_output(command).decode())
+    return computeRecovery(report["samples"], FAULT_AT)
+
+
+def printResults(title, results):
+    print("== %s ==" % title)
+    for fault in FAULTS:
+        if fault not in results:
+            continue
+        print("\n%s" % fault)
+        print("  %-24s" % "strategy" + "".join("%22s" % column for column in COLUMNS))
+        for strategy in sorted(results[fault]):
+            row = results[fault][strategy]
+            if "error" in row:
+                print("  %-24s  %s" % (strategy, row["error"]))
+                continue
+            print("  %-24s" % strategy +
+                  "".join("%22s" % ("%.3f" % row[column] if column in row else "-")
+                          for column in COLUMNS))
+    print()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Measure time-to-recover of the strategies after upstream faults')
+    parser.add_argument("-b", "--build-dir", default="build", help='directory holding strategy-recovery')
+    parser.add_argument("--simulation", default=None, help='use this strategy-recovery output instead of running it')
+    parser.add_argument("--testbed", action="store_true", help='also inject every fault on the local testbed')
+    parser.add_argument("--testbed-strategies", default=",".join(TESTBED_STRATEGIES),
+                        help='comma separated strategies to run on the testbed')
+    parser.add_argument("-t", "--duration", type=float, default=40.0, help='seconds per testbed run')
+    parser.add_argument("-o", "--output", default=None, help='also write the results as JSON to this file')
+
+    args = parser.parse_args()
+
+    try:
+        if args.simulation is not None:
+            with open(args.simulation) as simulation:
+                metrics = json.load(simulation)["metrics"]
+        else:
+            output = subprocess.check_output([os.path.join(args.build_dir, "strategy-recovery")])
+            metrics = json.loads(output.decode())["metrics"]
+
+        results = {"simulation": fromSimulation(metrics)}
+        printResults("simulation", results["simulation"])
+
+        if args.testbed:
+            testbed = {}
+            for fault in FAULTS:
+                for strategy in args.testbed_strategies.split(","):
+                    try:
+                        row = runTestbed(strategy, fault, args.duration)
+                    except subprocess.CalledProcessError as e:
+                        row = {"error": "testbed failed (exit status %d)" % e.returncode}
+                    testbed.setdefault(fault, {})[strategy] = row
+            results["testbed"] = testbed
+            printResults("testbed", testbed)
+
+        if args.output is not None:
+            with open(args.output, "w") as output:
+                json.dump(results, output, indent=2, sort_keys=True)
+
+    except:
+        traceback.print_exc(file=sys.stdout)
+        sys.exit(1)
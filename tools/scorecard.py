@@ -0,0 +1,154 @@
+# -*- Mode:python; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+#
+# Copyright (c) 2014 Susmit Shannigrahi, Steve DiBenedetto
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+# A copy of the GNU General Public License is in the file COPYING.
+
+'''Strategy scorecard across the standard scenarios.
+
+Collects throughput, p50/p99 latency, upstream Interest overhead and
+Jain's fairness index for every strategy in the heterogeneous RTT,
+capacity skew, link failure and flash crowd scenarios, from the
+simulator (benchmarks/strategy-simulation) and optionally from the local
+testbed, and prints them side by side.
+'''
+
+from __future__ import print_function
+
+import os
+import sys
+import json
+import argparse
+import subprocess
+import traceback
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+
+SCENARIOS = ["heterogeneous-rtt", "capacity-skew", "link-failure", "flash-crowd"]
+COLUMNS = ["throughput", "p50_ms", "p99_ms", "upstream_overhead", "fairness"]
+
+# testbed arguments reproducing each scenario with real producers
+TESTBED_SCENARIOS = {
+    "heterogeneous-rtt": ["-p", "0.01", "-p", "0.05", "-p", "0.1", "-r", "300"],
+    "capacity-skew": ["-p", "0.02:1000", "-p", "0.02:200", "-p", "0.02:100", "-r", "800"],
+    "link-failure": ["-p", "0.01", "-p", "0.03", "-p", "0.05", "-r", "300",
+                     "--fault", "0@5:freeze"],
+    "flash-crowd": ["-p", "0.02:500", "-p", "0.02:500", "-p", "0.02:250", "-r", "200",
+                    "--surge", "5:10:1000"],
+}
+TESTBED_STRATEGIES = ["weighted-load-balancer", "random-load-balancer",
+                      "best-route", "multicast", "asf"]
+
+
+def fairness(loads):
+    '''Jain's fairness index'''
+    total = sum(loads)
+    squares = sum(load * load for load in loads)
+    return total * total / (len(loads) * squares) if squares else 0.0
+
+
+def fromSimulation(metrics):
+    '''Regroup flat strategy/scenario/metric results by scenario and strategy'''
+    card = {}
+    for name, value in metrics.items():
+        strategy, scenario, metric = name.split("/")
+        if scenario in SCENARIOS:
+            card.setdefault(scenario, {}).setdefault(strategy, {})[metric] = value
+    return card
+
+
+def fromTestbed(report):
+    capacities = dict((profile["id"], profile["capacity"] or 1.0)
+                      for profile in report["producers"])
+    loads = [report["served_by"].get(producerId, {}).get("data", 0) / capacity
+             for producerId, capacity in capacities.items()]
+
+    return {
+        "throughput": report["throughput"],
+        "p50_ms": report["latency_ms"].get("p50"),
+        "p99_ms": report["latency_ms"].get("p99"),
+        "upstream_overhead": (float(report["upstream_interests"]) / report["interests"]
+                              if report["interests"] else 0.0),
+        "fairness": fairness(loads),
+    }
+
+
+def runTestbed(strategy, scenario, duration):
+    command = [sys.executable, os.path.join(TOOLS_DIR, "testbed.py"),
+               "-s", strategy, "-t", str(duration)] + TESTBED_SCENARIOS[scenario]
+    return json.loads(subprocess.check_output(command).decode())
+
+
+def printCard(title, card):
+    print("== %s ==" % title)
+    for scenario in SCENARIOS:
+        if scenario not in card:
+            continue
+        print("\n%s" % scenario)
+        print("  %-24s" % "strategy" + "".join("%18s" % column for column in COLUMNS))
+        for strategy in sorted(card[scenario]):
+            row = card[scenario][strategy]
+            if "error" in row:
+                print("  %-24s  %s" % (strategy, row["error"]))
+                continue
+            print("  %-24s" % strategy +
+                  "".join("%18s" % ("-" if row.get(column) is None else "%.3f" % row[column])
+                          for column in COLUMNS))
+    print()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Compare strategies on the standard scenarios')
+    parser.add_argument("-b", "--build-dir", default="build", help='directory holding strategy-simulation')
+    parser.add_argument("--simulation", default=None, help='use this strategy-simulation output instead of running it')
+    parser.add_argument("--testbed", action="store_true", help='also run every scenario on the local testbed')
+    parser.add_argument("--testbed-strategies", default=",".join(TESTBED_STRATEGIES),
+                        help='comma separated strategies installed in the local NFD')
+    parser.add_argument("-t", "--duration", type=float, default=20.0, help='seconds per testbed run')
+    parser.add_argument("-o", "--output", default=None, help='also write the scorecard as JSON to this file')
+
+    args = parser.parse_args()
+
+    try:
+        if args.simulation is not None:
+            with open(args.simulation) as simulation:
+                metrics = json.load(simulation)["metrics"]
+        else:
+            output = subprocess.check_output([os.path.join(args.build_dir, "strategy-simulation")]
+                                             + SCENARIOS)
+            metrics = json.loads(output.decode())["metrics"]
+
+        scorecard = {"simulation": fromSimulation(metrics)}
+        printCard("simulation", scorecard["simulation"])
+
+        if args.testbed:
+            testbed = {}
+            for scenario in SCENARIOS:
+                for strategy in args.testbed_strategies.split(","):
+                    try:
+                        row = fromTestbed(runTestbed(strategy, scenario, args.duration))
+                    except subprocess.CalledProcessError as e:
+                        row = {"error": "testbed failed (exit status %d)" % e.returncode}
+                    testbed.setdefault(scenario, {})[strategy] = row
+            scorecard["testbed"] = testbed
+            printCard("testbed", testbed)
+
+        if args.output is not None:
+            with open(args.output, "w") as output:
+                json.dump(scorecard, output, indent=2, sort_keys=True)
+
+    except:
+        traceback.print_exc(file=sys.stdout)
+        sys.exit(1)
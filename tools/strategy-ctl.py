@@ -0,0 +1,87 @@
+# -*- Mode:python; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+#
+# Copyright (c) 2014 Susmit Shannigrahi, Steve DiBenedetto
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+# A copy of the GNU General Public License is in the file COPYING.
+
+
+'''Client of the strategies' control socket.
+
+Sends one command to the socket given with the control=PATH strategy
+parameter (NFD_STRATEGY_CONTROL for the instances NFD creates) and
+prints the JSON reply, which holds the answer of every strategy
+instance keyed by strategy name.  With --target, only the instance of
+that name, or the instances under that name, answer.
+
+  python tools/strategy-ctl.py stats
+  python tools/strategy-ctl.py set selector=p2c ewma-gain=0.25
+  python tools/strategy-ctl.py -t /localhost/nfd/strategy/weighted-load-balancer inspect /hello/world
+'''
+
+from __future__ import print_function
+
+import os
+import sys
+import json
+import socket
+import argparse
+import traceback
+
+DEFAULT_SOCKET = os.environ.get("NFD_STRATEGY_CONTROL", "/run/nfd-strategy.sock")
+
+
+def request(path, command):
+    client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    try:
+        client.connect(path)
+        client.sendall((" ".join(command) + "\n").encode())
+
+        chunks = []
+        while True:
+            chunk = client.recv(65536)
+            if not chunk:
+                break
+            chunks.append(chunk)
+    finally:
+        client.close()
+
+    return json.loads(b"".join(chunks).decode())
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Query or control the strategies running in NFD')
+    parser.add_argument("-S", "--socket", default=DEFAULT_SOCKET, help='control socket of the strategies')
+    parser.add_argument("-t", "--target", help='strategy instance, or prefix of the instance names, to send the command to')
+    parser.add_argument("command", nargs="+", help='command and its arguments, e.g. stats')
+
+    args = parser.parse_args()
+
+    command = args.command
+    if args.target:
+        command = command[:1] + ["@" + args.target] + command[1:]
+
+    try:
+        reply = request(args.socket, command)
+        print(json.dumps(reply, indent=2, sort_keys=True))
+
+    except socket.error as e:
+        print("cannot reach %s: %s" % (args.socket, e), file=sys.stderr)
+        sys.exit(1)
+    except:
+        traceback.print_exc(file=sys.stdout)
+        sys.exit(1)
+
+    if "error" in reply:
+        sys.exit(1)
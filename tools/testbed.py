@@ -0,0 +1,364 @@
+# -*- Mode:python; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+#
+# Copyright (c) 2014 Susmit Shannigrahi, Steve DiBenedetto
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+# A copy of the GNU General Public License is in the file COPYING.
+
+'''Local end-to-end testbed for the forwarding strategies.
+
+Starts NFD, selects a strategy for the test prefix, launches one
+producer per delay/capacity profile (each on its own face), drives
+load through tools/loadgen.py and writes a JSON report with
+throughput, latency percentiles, per-face share and NFD CPU usage.
+'''
+
+from __future__ import print_function
+
+import os
+import re
+import sys
+import json
+import time
+import signal
+import shutil
+import argparse
+import threading
+import tempfile
+import traceback
+import subprocess
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+
+STRATEGY_PREFIX = "/localhost/nfd/strategy/"
+STRATEGIES = ["weighted-load-balancer", "random-load-balancer"]
+
+FACE_COUNTERS = re.compile(r"faceid=(\d+) .*?counters=\{in=\{(\d+)i (\d+)d(?: (\d+)B)?\} "
+                           r"out=\{(\d+)i (\d+)d(?: (\d+)B)?\}\}")
+FIB_ENTRY = re.compile(r"^\s*(\S+) nexthops=\{(.*)\}\s*$")
+NEXTHOP = re.compile(r"faceid=(\d+)")
+
+
+def parseProfile(text):
+    '''Parse a DELAY[:CAPACITY] producer profile'''
+    parts = text.split(":")
+    delay = float(parts[0])
+    capacity = float(parts[1]) if len(parts) > 1 and parts[1] else None
+    return {"delay": delay, "capacity": capacity}
+
+
+def parseFault(text):
+    '''Parse an INDEX@SECONDS:ACTION producer fault
+
+    ACTION is one of freeze, kill, normal, slow=FACTOR, loss=PROBABILITY
+    or flap=PERIOD (alternate between dropping and answering everything
+    every PERIOD seconds, ten times).
+    '''
+    target, action = text.split(":", 1)
+    index, at = target.split("@")
+    return (int(index), float(at), action)
+
+
+def readFaceCounters():
+    output = subprocess.check_output(["nfd-status", "-f"]).decode()
+    counters = {}
+    for match in FACE_COUNTERS.finditer(output):
+        faceId = int(match.group(1))
+        counters[faceId] = {
+            "in_interests": int(match.group(2)),
+            "in_data": int(match.group(3)),
+            "in_bytes": int(match.group(4) or 0),
+            "out_interests": int(match.group(5)),
+            "out_data": int(match.group(6)),
+            "out_bytes": int(match.group(7) or 0),
+        }
+    return counters
+
+
+def readNextHops(prefix):
+    output = subprocess.check_output(["nfd-status", "-b"]).decode()
+    for line in output.splitlines():
+        match = FIB_ENTRY.match(line)
+        if match is not None and match.group(1) == prefix:
+            return [int(faceId) for faceId in NEXTHOP.findall(match.group(2))]
+    return []
+
+
+def readCpuSeconds(pid):
+    '''User and system CPU seconds consumed so far by a process'''
+    with open("/proc/%d/stat" % pid) as stat:
+        # the command name may contain spaces, fields start after its ')'
+        fields = stat.read().rsplit(")", 1)[1].split()
+    ticks = float(os.sysconf("SC_CLK_TCK"))
+    return int(fields[11]) / ticks, int(fields[12]) / ticks
+
+
+def findNfdPid():
+    output = subprocess.check_output(["pgrep", "-x", "nfd"]).decode()
+    return int(output.split()[0])
+
+
+class Testbed(object):
+    '''Owns the NFD and producer processes of one testbed run'''
+
+    def __init__(self, args):
+        self.args = args
+        self.workDir = tempfile.mkdtemp(prefix="nfd-testbed-")
+        self.nfd = None
+        self.nfdPid = None
+        self.producers = []
+
+
+    def run(self):
+        try:
+            self.startNfd()
+            self.setStrategy()
+            self.startProducers()
+            return self.measure()
+        finally:
+            self.stop()
+
+
+    def startNfd(self):
+        if self.args.use_running_nfd:
+            self.nfdPid = findNfdPid()
+            return
+
+        command = [self.args.nfd]
+        if self.args.nfd_config is not None:
+            command += ["--config", self.args.nfd_config]
+
+        log = open(os.path.join(self.workDir, "nfd.log"), "w")
+        self.nfd = subprocess.Popen(command, stdout=log, stderr=subprocess.STDOUT)
+        self.nfdPid = self.nfd.pid
+
+        self._waitFor(lambda: subprocess.call(["nfd-status", "-v"],
+                                              stdout=open(os.devnull, "w"),
+                                              stderr=subprocess.STDOUT) == 0,
+                      "NFD to accept management commands")
+
+
+    def setStrategy(self):
+        subprocess.check_call(["nfdc", "set-strategy", self.args.prefix,
+                               STRATEGY_PREFIX + self.args.strategy])
+
+
+    def startProducers(self):
+        for index, profile in enumerate(self.args.profiles):
+            command = [sys.executable, os.path.join(TOOLS_DIR, "producer.py"),
+                       "-n", self.args.prefix, "-d", str(profile["delay"]),
+                       "-i", profile["id"]]
+            if profile["capacity"] is not None:
+                command += ["-c", str(profile["capacity"])]
+
+            log = open(os.path.join(self.workDir, "producer-%d.log" % index), "w")
+            process = subprocess.Popen(command, stdin=subprocess.PIPE,
+                                       stdout=log, stderr=subprocess.STDOUT)
+            self.producers.append(process)
+
+        self._waitFor(lambda: len(readNextHops(self.args.prefix)) >= len(self.producers),
+                      "all producers to register %s" % self.args.prefix)
+
+
+    def measure(self):
+        nexthops = readNextHops(self.args.prefix)
+        countersBefore = readFaceCounters()
+        cpuBefore = readCpuSeconds(self.nfdPid)
+
+        loadReport = os.path.join(self.workDir, "load.json")
+        command = [sys.executable, os.path.join(TOOLS_DIR, "loadgen.py"),
+                   "-n", self.args.prefix,
+                   "-t", str(self.args.duration),
+                   "-m", self.args.mode,
+                   "-r", str(self.args.rate),
+                   "-w", str(self.args.window),
+                   "-o", loadReport]
+        if self.args.surge is not None:
+            command += ["-s", self.args.surge]
+        if self.args.samples:
+            command += ["--samples"]
+
+        timers = []
+        for index, at, action in self.args.faults:
+            for offset, step in self.expandFault(action):
+                timers.append(threading.Timer(at + offset, self.injectFault, [index, step]))
+        for timer in timers:
+            timer.start()
+
+        try:
+            subprocess.check_call(command)
+        finally:
+            for timer in timers:
+                timer.cancel()
+
+        cpuAfter = readCpuSeconds(self.nfdPid)
+        countersAfter = readFaceCounters()
+
+        with open(loadReport) as report:
+            load = json.load(report)
+
+        faces = {}
+        totalOut = 0
+        for faceId in nexthops:
+            before = countersBefore.get(faceId, {}).get("out_interests", 0)
+            after = countersAfter.get(faceId, {}).get("out_interests", 0)
+            faces[faceId] = {"out_interests": after - before}
+            totalOut += after - before
+
+        for faceId in faces:
+            faces[faceId]["share"] = (float(faces[faceId]["out_interests"]) / totalOut
+                                      if totalOut else 0.0)
+
+        userCpu = cpuAfter[0] - cpuBefore[0]
+        systemCpu = cpuAfter[1] - cpuBefore[1]
+
+        return {
+            "strategy": self.args.strategy,
+            "mode": self.args.mode,
+            "prefix": self.args.prefix,
+            "producers": self.args.profiles,
+            "throughput": load["throughput"],
+            "interests": load["interests"],
+            "data": load["data"],
+            "timeouts": load["timeouts"],
+            "satisfaction": load["satisfaction"],
+            "latency_ms": load["latency_ms"],
+            "served_by": load["producers"],
+            "faces": dict((str(faceId), value) for faceId, value in faces.items()),
+            "upstream_interests": totalOut,
+            "nfd_cpu": {
+                "user_seconds": userCpu,
+                "system_seconds": systemCpu,
+                "percent": 100.0 * (userCpu + systemCpu) / load["duration"],
+            },
+            "faults": [{"producer": index, "at": at, "action": action}
+                       for index, at, action in self.args.faults],
+            "samples": load.get("samples"),
+        }
+
+
+    def expandFault(self, action):
+        '''Split a fault into (offset, step) pairs applied one by one'''
+        if action.startswith("flap="):
+            period = float(action[len("flap="):])
+            return [(period * i, "loss=1" if i % 2 == 0 else "normal") for i in range(10)]
+        return [(0.0, action)]
+
+
+    def injectFault(self, index, step):
+        producer = self.producers[index]
+        if step == "freeze":
+            # the face stays up but nothing is answered
+            producer.send_signal(signal.SIGSTOP)
+        elif step == "kill":
+            # the producer's face goes down with it
+            producer.kill()
+        elif step == "normal":
+            self._command(producer, "normal")
+        else:
+            name, value = step.split("=")
+            self._command(producer, "%s %s" % (name, value))
+
+
+    def _command(self, producer, line):
+        producer.stdin.write((line + "\n").encode())
+        producer.stdin.flush()
+
+
+    def stop(self):
+        for process in self.producers:
+            if process.poll() is None:
+                process.send_signal(signal.SIGCONT)
+                process.terminate()
+                process.wait()
+
+        if self.nfd is not None and self.nfd.poll() is None:
+            self.nfd.terminate()
+            self.nfd.wait()
+
+        if self.args.keep_logs:
+            print("logs kept in %s" % self.workDir, file=sys.stderr)
+        else:
+            shutil.rmtree(self.workDir, ignore_errors=True)
+
+
+    def _waitFor(self, condition, what, timeout=10.0):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            if condition():
+                return
+            time.sleep(0.2)
+        raise RuntimeError("timed out waiting for %s" % what)
+
+
+def makeParser():
+    parser = argparse.ArgumentParser(description='Run a local NFD testbed and report strategy performance as JSON')
+    parser.add_argument("-s", "--strategy", required=True,
+                        help='strategy to install on the test prefix, e.g. %s or a built-in such as best-route'
+                        % " or ".join(STRATEGIES))
+    parser.add_argument("-m", "--mode", choices=["open", "closed"], default="open", help='load mode: fixed rate or fixed window')
+    parser.add_argument("-p", "--producer", dest="profiles", action="append", type=parseProfile, default=[],
+                        help='producer profile DELAY[:CAPACITY] (seconds, Data/s); repeat once per producer')
+    parser.add_argument("-N", "--producers", type=int, default=None,
+                        help='number of producers with generated profiles when no --producer is given')
+    parser.add_argument("-n", "--prefix", default="/testbed", help='namespace served by the producers')
+    parser.add_argument("-t", "--duration", type=float, default=30.0, help='seconds of load')
+    parser.add_argument("-r", "--rate", type=float, default=100.0, help='Interests per second in open mode')
+    parser.add_argument("-w", "--window", type=int, default=10, help='outstanding Interests in closed mode')
+    parser.add_argument("--surge", default=None, help='START:END:RATE load surge passed to the load generator')
+    parser.add_argument("--fault", dest="faults", action="append", type=parseFault, default=[],
+                        help='INDEX@SECONDS:ACTION applied to producer INDEX after SECONDS of load; '
+                        'ACTION is freeze, kill, normal, slow=FACTOR, loss=PROBABILITY or flap=PERIOD')
+    parser.add_argument("--samples", action="store_true", help='include every Interest outcome in the report')
+    parser.add_argument("-o", "--output", default=None, help='write the JSON report to this file instead of stdout')
+    parser.add_argument("--nfd", default="nfd", help='NFD executable to start')
+    parser.add_argument("--nfd-config", default=None, help='configuration file passed to NFD')
+    parser.add_argument("--use-running-nfd", action="store_true", help='measure an already running NFD instead of starting one')
+    parser.add_argument("--keep-logs", action="store_true", help='keep NFD, producer and load generator logs')
+    return parser
+
+
+def completeProfiles(args):
+    '''Generate distinct delay/capacity profiles when none were given'''
+    if args.profiles:
+        return
+    for index in range(args.producers or 3):
+        args.profiles.append({"delay": 0.01 * (index + 1),
+                              "capacity": 400.0 / (index + 1)})
+
+
+def nameProfiles(args):
+    '''Give every producer the ID it stamps into its Data'''
+    for index, profile in enumerate(args.profiles):
+        profile["id"] = "p%d" % index
+
+
+if __name__ == "__main__":
+    args = makeParser().parse_args()
+    completeProfiles(args)
+    nameProfiles(args)
+
+    try:
+        report = Testbed(args).run()
+
+        if args.output is None:
+            json.dump(report, sys.stdout, indent=2, sort_keys=True)
+            print()
+        else:
+            with open(args.output, "w") as output:
+                json.dump(report, output, indent=2, sort_keys=True)
+
+    except:
+        traceback.print_exc(file=sys.stdout)
+        sys.exit(1)
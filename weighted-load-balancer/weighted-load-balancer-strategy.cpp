@@ -24,22 +24,24 @@
  */
 
 #include <random>
+#include <chrono>
+#include <cmath>
 #include <algorithm>
-
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/identity.hpp>
-#include <boost/multi_index/mem_fun.hpp>
+#include <cstdlib>
+#include <sstream>
 
 #include <boost/chrono/system_clocks.hpp>
 
 #include <ndn-cxx/util/time.hpp>
 
 #include "weighted-load-balancer-strategy.hpp"
+#include "strategy-control.hpp"
 
+#include "core/global-io.hpp"
 #include "core/logger.hpp"
 #include "table/measurements-entry.hpp"
+#include "table/name-tree.hpp"
+#include "table/strategy-choice.hpp"
 
 using namespace ndn::time;
 using namespace boost::multi_index;
@@ -47,138 +49,372 @@ using namespace boost::multi_index;
 namespace nfd {
 namespace fw {
 
-class MyPitInfo;
-class MyMeasurementInfo;
-class WeightedFace;
-
-class WeightedFace
-{
-public:
-
-  WeightedFace(shared_ptr<Face> face_,
-               const milliseconds& delay = milliseconds(0))
-    : face(face_)
-    , lastDelay(delay)
-  {
-    calculateWeight();
-  }
-
-  bool
-  operator<(const WeightedFace& other) const
-  {
-    if (lastDelay == other.lastDelay)
-      return face->getId() < other.face->getId();
-
-    return lastDelay < other.lastDelay;
-  }
-
-  FaceId
-  getId() const
-  {
-    return face->getId();
-  }
-
-  static void
-  modifyWeightedFaceDelay(WeightedFace& weightedFace,
-                          const ndn::time::milliseconds& delay)
-  {
-    weightedFace.lastDelay = delay;
-    weightedFace.calculateWeight();
-  }
-
-  void
-  calculateWeight()
-  {
-    weight = (1.0 * (milliseconds::max() - lastDelay)) / milliseconds::max();
-  }
-
-  shared_ptr<Face> face;
-  ndn::time::milliseconds lastDelay;
-  double weight;
+size_t MyPitInfo::s_nLive = 0;
+
+NFD_LOG_INCLASS_DEFINE(MyMeasurementInfo, "MyMeasurementInfo");
+
+size_t MyMeasurementInfo::s_nLive = 0;
+
+/////////////////////////////
+// Strategy Implementation //
+/////////////////////////////
+
+NFD_LOG_INIT("WeightedLoadBalancerStrategy");
+
+const Name WeightedLoadBalancerStrategy::STRATEGY_NAME("ndn:/localhost/nfd/strategy/weighted-load-balancer");
+NFD_REGISTER_STRATEGY(WeightedLoadBalancerStrategy);
+
+const std::set<std::string> WeightedLoadBalancerStrategy::LIVE_PARAMETERS = {
+  "selector", "estimator", "candidate-selector", "candidate-estimator", "candidate-fraction",
+  "ewma-gain", "measurements-lifetime", "propagation-depth",
+  "retry-budget-ratio", "retry-budget-window", "retry-budget-min",
+  "shed-pit-high", "shed-pit-low", "shed-pending-high", "shed-pending-low", "shed-classes",
+  "probe-interval", "probe-name", "probe-lifetime", "prefetch", "prefetch-budget",
+  "model-objective", "model-interval"
 };
 
-///////////////////////
-// PIT entry storage //
-///////////////////////
+const size_t WeightedLoadBalancerStrategy::INSPECTION_SLICE = 256;
 
-class MyPitInfo : public StrategyInfo
+static shared_ptr<MyMeasurementInfo>
+getMeasurementInfo(const name_tree::Entry& entry)
 {
-public:
-  MyPitInfo()
-    : creationTime(system_clock::now())
-  {}
+  auto measurementsEntry = entry.getMeasurementsEntry();
+  return measurementsEntry == nullptr ? nullptr :
+         measurementsEntry->getStrategyInfo<MyMeasurementInfo>();
+}
 
-  static int constexpr
-  getTypeId() { return 9970; }
+static FaceSelector
+parseSelector(const std::string& value)
+{
+  if (value == "weighted")
+    return SELECTOR_WEIGHTED;
+  if (value == "p2c")
+    return SELECTOR_P2C;
+  if (value == "model")
+    return SELECTOR_MODEL;
+  throw StrategyParameters::Error("unknown selector '" + value + "'");
+}
 
-  system_clock::TimePoint creationTime;
-};
+static DelayEstimator
+parseEstimator(const std::string& value)
+{
+  if (value == "last")
+    return ESTIMATOR_LAST;
+  if (value == "ewma")
+    return ESTIMATOR_EWMA;
+  throw StrategyParameters::Error("unknown estimator '" + value + "'");
+}
 
-///////////////////////////////
-// Measurement entry storage //
-///////////////////////////////
+static ModelObjective
+parseObjective(const std::string& value)
+{
+  if (value == "mean")
+    return OBJECTIVE_MEAN;
+  if (value == "p99")
+    return OBJECTIVE_P99;
+  throw StrategyParameters::Error("unknown model objective '" + value + "'");
+}
 
-class MyMeasurementInfo : public StrategyInfo
+static const char*
+toString(FaceSelector selector)
 {
-public:
+  switch (selector)
+    {
+    case SELECTOR_P2C:
+      return "p2c";
+    case SELECTOR_MODEL:
+      return "model";
+    default:
+      return "weighted";
+    }
+}
 
-  MyMeasurementInfo() : weightedFaces(new WeightedFaceSet) {}
-  void
-  updateFaceDelay(const Face& face, const milliseconds& delay);
+static const char*
+toString(ModelObjective objective)
+{
+  return objective == OBJECTIVE_P99 ? "p99" : "mean";
+}
 
-  void
-  updateStoredNextHops(const fib::NextHopList& nexthops);
+static const char*
+toString(DelayEstimator estimator)
+{
+  return estimator == ESTIMATOR_EWMA ? "ewma" : "last";
+}
 
-  static int constexpr
-  getTypeId() { return 9971; }
+WeightedLoadBalancerStrategy::WeightedLoadBalancerStrategy(Forwarder& forwarder,
+                                                           const Name& name)
+  : Strategy(forwarder, name)
+  , m_parameters(name, STRATEGY_NAME)
+  , m_nPendingInterests(make_shared<size_t>(0))
+  , m_pit(forwarder.getPit())
+  , m_faceTable(forwarder.getFaceTable())
+  , m_nameTree(forwarder.getNameTree())
+  , m_strategyChoice(forwarder.getStrategyChoice())
+{
+  const StrategyParameters& parameters = m_parameters;
 
-public:
+  // an explicit seed makes the choices reproducible, see strategy-replay
+  const uint64_t seed = parameters.getUnsigned("seed", std::random_device()());
+  m_randomGenerator.seed(seed);
 
-  struct ByDelay {};
-  struct ByFaceId {};
+  // before configure(), which sets up the latency model the shadow may need
+  if (parameters.has("shadow-selector") || parameters.has("shadow-estimator"))
+    {
+      m_shadow.reset(new Shadow);
+      m_shadow->policy.selector =
+        parseSelector(parameters.get("shadow-selector", parameters.get("selector", "weighted")));
+      m_shadow->policy.estimator =
+        parseEstimator(parameters.get("shadow-estimator", parameters.get("estimator", "last")));
+      m_shadow->randomGenerator.seed(seed + 1);
+    }
 
-  typedef multi_index_container<
-    WeightedFace,
-    indexed_by<
-      ordered_unique<
-        tag<ByDelay>,
-        identity<WeightedFace>
-        >,
-      hashed_unique<
-        tag<ByFaceId>,
-        const_mem_fun<WeightedFace, FaceId, &WeightedFace::getId>
-        >
-      >
-    > WeightedFaceSet;
+  configure(parameters);
 
-  typedef WeightedFaceSet::index<ByDelay>::type WeightedFaceSetByDelay;
-  typedef WeightedFaceSet::index<ByFaceId>::type WeightedFaceSetByFaceId;
+  m_isHandoffEnabled = parameters.getUnsigned("handoff", 1) != 0;
 
-  unique_ptr<WeightedFaceSet> weightedFaces;
+  m_loadInterval = milliseconds(parameters.getUnsigned("load-interval", 0));
+  m_defaultLinkCapacity = parameters.getDouble("link-capacity-default", 0) * 1e6;
+  std::istringstream capacities(parameters.get("link-capacity"));
+  for (std::string item; std::getline(capacities, item, ','); )
+    {
+      const size_t separator = item.rfind('=');
+      char* end = nullptr;
+      const double mbits = separator == std::string::npos ? 0 :
+                           std::strtod(item.c_str() + separator + 1, &end);
+      if (end == nullptr || *end != '\0' || mbits <= 0)
+        throw StrategyParameters::Error("link capacity '" + item + "' is not URI=MBITS");
+      m_linkCapacities[item.substr(0, separator)] = mbits * 1e6;
+    }
+  if (m_loadInterval > milliseconds::zero())
+    sampleFaceLoads();
 
-private:
-  NFD_LOG_INCLASS_DECLARE();
-};
+  if (parameters.has("shared-table"))
+    {
+      m_sharedFaces = SharedFaceTable::open(parameters.get("shared-table"),
+                                            forwarder.getFaceTable(),
+                                            parameters.getUnsigned("shared-table-capacity", 4096));
+    }
 
-NFD_LOG_INCLASS_DEFINE(MyMeasurementInfo, "MyMeasurementInfo");
+  StrategyControl& control = StrategyControl::getInstance();
+  if (parameters.has("control"))
+    control.listen(parameters.get("control"), parameters.get("control-group"));
+  control.setHandler(getName(), "stats",
+                     [this] (const std::vector<std::string>&, std::ostream& reply) {
+                       writeStats(reply);
+                     });
+  control.setCheckedHandler(getName(), "set",
+                            [this] (const std::vector<std::string>& arguments,
+                                    std::vector<std::string>& accepted) {
+                              return reconfigure(arguments, accepted);
+                            });
+  control.setCheckedHandler(getName(), StrategyConfig::RELOAD_COMMAND,
+                            [this] (const std::vector<std::string>&,
+                                    std::vector<std::string>& changed) {
+                              return reloadDefaults(changed);
+                            });
+  control.setAsyncHandler(getName(), "inspect",
+                          [this] (const std::vector<std::string>& arguments,
+                                  const StrategyControl::ReplyCallback& done) {
+                            inspect(arguments, done);
+                          });
+
+  if (parameters.has("record"))
+    {
+      // these act on inputs the log does not hold, so a replay would differ
+      std::vector<std::string> unrecorded;
+      if (m_loadInterval > milliseconds::zero())
+        unrecorded.push_back("load-interval");
+      if (m_sharedFaces != nullptr)
+        unrecorded.push_back("shared-table");
+      if (m_prober != nullptr)
+        unrecorded.push_back("probe-interval");
+      if (m_prefetcher != nullptr)
+        unrecorded.push_back("prefetch");
+      if (m_model != nullptr)
+        unrecorded.push_back("selector=model");
+      if (!unrecorded.empty())
+        NFD_LOG_WARN("the log of " << getName() << " will not replay, it lacks the inputs of "
+                     << unrecorded.size() << " enabled feature(s)");
+
+      m_recorder.reset(new StrategyRecorder(parameters.get("record"),
+                                            StrategyRecorder::makeRecordedName(parameters,
+                                                                               STRATEGY_NAME,
+                                                                               unrecorded),
+                                            seed));
+    }
 
-/////////////////////////////
-// Strategy Implementation //
-/////////////////////////////
+  if (parameters.getUnsigned("history", 0) > 0)
+    {
+      m_history.reset(new StrategyHistory(seconds(60 * parameters.getUnsigned("history", 0))));
+      m_history->setControlHandlers(getName());
+    }
+}
 
-NFD_LOG_INIT("WeightedLoadBalancerStrategy");
+void
+WeightedLoadBalancerStrategy::configure(const StrategyParameters& parameters, bool isDryRun)
+{
+  const double retryRatio = parameters.getDouble("retry-budget-ratio", 0);
+  const seconds retryWindow(parameters.getUnsigned("retry-budget-window", 10));
+  const double retryMin = parameters.getDouble("retry-budget-min", 10);
+  const LoadShedder loadShedder(parameters);
+
+  const SelectionPolicy policy{parseSelector(parameters.get("selector", "weighted")),
+                               parseEstimator(parameters.get("estimator", "last"))};
+
+  // A/B experiment: a fraction of the names goes to a candidate policy
+  const bool hasCandidate = parameters.has("candidate-selector") ||
+                            parameters.has("candidate-estimator");
+  const SelectionPolicy candidate{
+    parseSelector(parameters.get("candidate-selector", toString(policy.selector))),
+    parseEstimator(parameters.get("candidate-estimator", toString(policy.estimator)))};
+  const double candidateFraction = parameters.getDouble("candidate-fraction", 0.1);
+
+  Tuning tuning;
+  tuning.ewmaGain = parameters.getDouble("ewma-gain", 0.125);
+  if (tuning.ewmaGain <= 0 || tuning.ewmaGain > 1)
+    throw StrategyParameters::Error("ewma-gain must be in (0, 1]");
+  tuning.measurementsLifetime = seconds(parameters.getUnsigned("measurements-lifetime", 16));
+  tuning.propagationDepth = parameters.getUnsigned("propagation-depth", 0);
+
+  const milliseconds probeInterval(parameters.getUnsigned("probe-interval", 0));
+  const Name probeSuffix(parameters.get("probe-name", "/probe"));
+  const milliseconds probeLifetime(parameters.getUnsigned("probe-lifetime", 1000));
+
+  const size_t prefetchDepth = parameters.getUnsigned("prefetch", 0);
+  const size_t prefetchBudget = parameters.getUnsigned("prefetch-budget", 32);
+
+  const ModelObjective modelObjective = parseObjective(parameters.get("model-objective", "mean"));
+  const milliseconds modelInterval(parameters.getUnsigned("model-interval", 1000));
+  if (modelInterval <= milliseconds::zero())
+    throw StrategyParameters::Error("model-interval must be positive");
+  const bool usesModel = policy.selector == SELECTOR_MODEL ||
+                         (hasCandidate && candidate.selector == SELECTOR_MODEL) ||
+                         (m_shadow != nullptr && m_shadow->policy.selector == SELECTOR_MODEL);
+
+  // nothing below throws
+  if (isDryRun)
+    return;
+
+  m_tuning = tuning;
+  m_retryBudget.setLimits(retryRatio, retryWindow, retryMin);
+  m_loadShedder.setLimits(loadShedder);
+
+  if (m_arms.empty())
+    m_arms.push_back(Arm{"control", policy, ForwardingStats()});
+  m_arms[0].policy = policy;
+
+  // the candidate arm stays once it exists, PIT entries may refer to it
+  m_candidateFraction = 0;
+  if (hasCandidate)
+    {
+      if (m_arms.size() < 2)
+        m_arms.push_back(Arm{"candidate", candidate, ForwardingStats()});
+      m_arms[1].policy = candidate;
+      m_candidateFraction = candidateFraction;
+    }
 
-const Name WeightedLoadBalancerStrategy::STRATEGY_NAME("ndn:/localhost/nfd/strategy/weighted-load-balancer");
-NFD_REGISTER_STRATEGY(WeightedLoadBalancerStrategy);
+  if (probeInterval > milliseconds::zero())
+    {
+      if (m_prober == nullptr)
+        m_prober.reset(new Prober);
+      m_prober->suffix = probeSuffix;
+      m_prober->interval = probeInterval;
+      m_prober->lifetime = probeLifetime;
+    }
+  else
+    {
+      m_prober.reset();
+    }
 
-WeightedLoadBalancerStrategy::WeightedLoadBalancerStrategy(Forwarder& forwarder,
-                                                           const Name& name)
-  : Strategy(forwarder, name)
+  if (prefetchDepth > 0)
+    {
+      if (m_prefetcher == nullptr)
+        m_prefetcher.reset(new Prefetcher);
+      m_prefetcher->depth = prefetchDepth;
+      m_prefetcher->budget = prefetchBudget;
+    }
+  else
+    {
+      m_prefetcher.reset();
+    }
+
+  if (usesModel)
+    {
+      const bool isNew = m_model == nullptr;
+      if (isNew)
+        m_model.reset(new LatencyModel);
+      m_model->objective = modelObjective;
+      m_model->interval = modelInterval;
+      if (isNew)
+        fitLatencyModels();
+    }
+  else
+    {
+      m_model.reset();
+    }
+}
+
+StrategyControl::Action
+WeightedLoadBalancerStrategy::reconfigure(const std::vector<std::string>& arguments,
+                                          std::vector<std::string>& accepted)
+{
+  accepted = StrategyParameters::select(arguments, LIVE_PARAMETERS);
+
+  StrategyParameters parameters = m_parameters;
+  parameters.update(accepted, LIVE_PARAMETERS);
+  return prepareParameters(parameters);
+}
+
+StrategyControl::Action
+WeightedLoadBalancerStrategy::reloadDefaults(std::vector<std::string>& changed)
+{
+  StrategyParameters parameters = m_parameters;
+  parameters.setConfig(StrategyConfig::getCurrent());
+  changed = parameters.findChanges(m_parameters, LIVE_PARAMETERS);
+  return prepareParameters(parameters);
+}
+
+StrategyControl::Action
+WeightedLoadBalancerStrategy::prepareParameters(const StrategyParameters& parameters)
 {
+  configure(parameters, true);
+
+  return [this, parameters] (std::ostream& reply) {
+      configure(parameters);
+      m_parameters = parameters;
+
+      NFD_LOG_INFO("reconfigured " << getName());
+
+      reply << "{\"parameters\": ";
+      writeJsonString(reply, m_parameters.makeName(STRATEGY_NAME, {}).toUri());
+      reply << "}";
+    };
 }
 
 WeightedLoadBalancerStrategy::~WeightedLoadBalancerStrategy()
 {
+  StrategyControl::getInstance().removeHandlers(getName());
+
+  for (const auto& inspection : m_inspections)
+    inspection->done("{\"error\": \"strategy removed\"}");
+  m_inspections.clear();
+
+  if (m_syntheticFace != nullptr)
+    m_syntheticFace->close();
+
+  scheduler::cancel(m_loadSampling);
+}
+
+size_t
+WeightedLoadBalancerStrategy::getNLivePitInfos()
+{
+  return MyPitInfo::s_nLive;
+}
+
+size_t
+WeightedLoadBalancerStrategy::getNLiveMeasurementInfos()
+{
+  return MyMeasurementInfo::s_nLive;
 }
 
 void
@@ -189,6 +425,35 @@ WeightedLoadBalancerStrategy::afterReceiveInterest(const Face& inFace,
 {
   NFD_LOG_TRACE("Received Interest: " << interest.getName());
 
+  if (m_syntheticFace != nullptr && inFace.getId() == m_syntheticFace->getId())
+    {
+      forwardSynthetic(interest, pitEntry);
+      return;
+    }
+
+  if (m_recorder != nullptr)
+    m_recorder->recordInterest(inFace, interest, *fibEntry);
+
+  if (m_prefetcher != nullptr)
+    {
+      prefetchAfter(interest.getName(), fibEntry);
+
+      auto existing = pitEntry->getStrategyInfo<MyPitInfo>();
+      if (existing != nullptr && existing->origin == MyPitInfo::ORIGIN_PREFETCH)
+        {
+          if (pitEntry->hasUnexpiredOutRecords())
+            {
+              // the Data is on its way already
+              ++m_prefetcher->nJoined;
+              return;
+            }
+
+          // the prefetch timed out; the consumer's Interest takes over
+          existing->origin = MyPitInfo::ORIGIN_DOWNSTREAM;
+          m_prefetcher->pending.erase(pitEntry->getName());
+        }
+    }
+
   const auto suppression = m_retxSuppression.decide(inFace, interest, *pitEntry);
 
   NFD_LOG_DEBUG("retx decision: " << suppression);
@@ -200,24 +465,119 @@ WeightedLoadBalancerStrategy::afterReceiveInterest(const Face& inFace,
     }
 
   // create timer information and attach to PIT entry
+  const bool isNewPitEntry = pitEntry->getStrategyInfo<MyPitInfo>() == nullptr;
   auto pitEntryInfo = myGetOrCreateMyPitInfo(pitEntry);
+  if (isNewPitEntry)
+    {
+      pitEntryInfo->arm = selectArm(interest.getName());
+      pitEntryInfo->pending.reset(new PendingInterestToken(m_nPendingInterests));
+      ++m_arms[pitEntryInfo->arm].stats.nInterests;
+    }
+  Arm& arm = m_arms[pitEntryInfo->arm];
+
   auto measurementsEntryInfo = myGetOrCreateMyMeasurementInfo(fibEntry);
 
   // reconcile differences between incoming nexthops and those stored
   // on our custom measurement entry info
   measurementsEntryInfo->updateStoredNextHops(fibEntry->getNextHops());
 
+  if (m_sharedFaces != nullptr)
+    applySharedFaces(*measurementsEntryInfo);
+
+  // under PIT pressure, don't let Interests wait out their lifetime on a
+  // prefix whose every face has timed out
+  if (m_loadShedder.isEnabled() && !pitEntry->hasUnexpiredOutRecords() &&
+      !measurementsEntryInfo->weightedFaces->empty() &&
+      !measurementsEntryInfo->hasHealthyFace() &&
+      m_loadShedder.shouldShed(interest.getName(), m_pit.size(), *m_nPendingInterests))
+    {
+      NFD_LOG_DEBUG("shedding " << interest.getName() << ", no healthy face");
+      ++arm.stats.nRejected;
+
+      if (m_recorder != nullptr)
+        m_recorder->recordReject();
+
+      rejectPendingInterest(pitEntry);
+      return;
+    }
+
+  const auto selectionStart = std::chrono::steady_clock::now();
   auto selectedFace = selectOutgoingFace(inFace,
                                          interest,
                                          measurementsEntryInfo,
-                                         pitEntry);
+                                         pitEntry,
+                                         arm.policy,
+                                         m_randomGenerator);
+
+  if (m_shadow != nullptr)
+    {
+      m_shadow->activeSelectionNs +=
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() -
+                                                 selectionStart).count();
+      evaluateShadow(inFace, interest, measurementsEntryInfo, pitEntry, *pitEntryInfo,
+                     selectedFace);
+    }
+
+  if (m_prober != nullptr)
+    probeFaces(*fibEntry, *measurementsEntryInfo, inFace);
 
   if (selectedFace == nullptr)
     {
+      ++arm.stats.nRejected;
+
+      if (m_recorder != nullptr)
+        m_recorder->recordReject();
+
       rejectPendingInterest(pitEntry);
       return;
     }
 
+  // retransmissions draw from the retry budget, first transmissions fill
+  // it; only Interests that are sent count
+  if (pitEntry->getOutRecords().empty())
+    {
+      m_retryBudget.deposit();
+    }
+  else if (!m_retryBudget.tryWithdraw())
+    {
+      NFD_LOG_DEBUG("retry budget exhausted, not forwarding " << interest.getName());
+
+      if (m_recorder != nullptr)
+        m_recorder->recordHold();
+      return;
+    }
+
+  if (m_recorder != nullptr)
+    m_recorder->recordForward(*selectedFace);
+
+  if (m_model != nullptr)
+    m_model->countInterest(selectedFace->getId());
+
+  auto& facesById = measurementsEntryInfo->weightedFaces->get<MyMeasurementInfo::ByFaceId>();
+  auto forwardedFace = facesById.find(selectedFace->getId());
+  if (forwardedFace != facesById.end())
+    ++forwardedFace->nForwarded;
+  ++measurementsEntryInfo->nForwarded;
+
+  if (m_history != nullptr)
+    {
+      shared_ptr<StrategyHistory::FaceCounters> counters;
+      if (forwardedFace == facesById.end())
+        {
+          counters = m_history->getCounters(selectedFace->getId());
+        }
+      else
+        {
+          if (forwardedFace->history == nullptr)
+            forwardedFace->history = m_history->getCounters(selectedFace->getId());
+          counters = forwardedFace->history;
+        }
+
+      ++counters->nInterests;
+      pitEntryInfo->inFlight.reset(new StrategyHistory::InFlight(selectedFace->getId(), counters));
+    }
+
+  ++arm.stats.nUpstreamInterests;
   sendInterest(pitEntry, selectedFace);
 }
 
@@ -228,7 +588,46 @@ WeightedLoadBalancerStrategy::beforeSatisfyInterest(shared_ptr<pit::Entry> pitEn
                                                     const Data& data)
 {
   NFD_LOG_TRACE("Received Data: " << data.getName());
+
   auto pitInfo = pitEntry->getStrategyInfo<MyPitInfo>();
+  const bool isSynthetic = pitInfo != nullptr &&
+                           pitInfo->origin != MyPitInfo::ORIGIN_DOWNSTREAM;
+
+  if (m_recorder != nullptr && !isSynthetic)
+    m_recorder->recordData(inFace, *pitEntry, data);
+
+  if (m_prefetcher != nullptr)
+    noteFinalSegment(data);
+
+  if (m_history != nullptr && pitInfo != nullptr && pitInfo->inFlight != nullptr)
+    {
+      const StrategyHistory::InFlight& inFlight = *pitInfo->inFlight;
+      if (inFlight.getFaceId() == inFace.getId())
+        {
+          StrategyHistory::countData(inFlight.getCounters(),
+                                     steady_clock::now() - inFlight.getSendTime());
+        }
+      else
+        {
+          // answered by a face of an earlier transmission
+          for (const auto& outRecord : pitEntry->getOutRecords())
+            {
+              if (outRecord.getFace()->getId() == inFace.getId())
+                StrategyHistory::countData(*m_history->getCounters(inFace.getId()),
+                                           steady_clock::now() - outRecord.getLastRenewed());
+            }
+        }
+      pitInfo->inFlight.reset();
+    }
+
+  if (m_model != nullptr)
+    {
+      for (const auto& outRecord : pitEntry->getOutRecords())
+        {
+          if (outRecord.getFace()->getId() == inFace.getId())
+            m_model->countData(inFace.getId(), steady_clock::now() - outRecord.getLastRenewed());
+        }
+    }
 
   // No start time available, cannot compute delay for this retrieval
   if (pitInfo == nullptr)
@@ -242,6 +641,47 @@ WeightedLoadBalancerStrategy::beforeSatisfyInterest(shared_ptr<pit::Entry> pitEn
 
   NFD_LOG_TRACE("Computed delay of: " << system_clock::now() << " - " << pitInfo->creationTime << " = " << delay);
 
+  if (m_sharedFaces != nullptr)
+    m_sharedFaces->recordRtt(inFace, delay);
+
+  if (pitInfo->origin == MyPitInfo::ORIGIN_PROBE)
+    {
+      NFD_LOG_DEBUG("probe answered by FaceId " << inFace.getId() << " in " << delay);
+      if (m_prober != nullptr)
+        {
+          ++m_prober->nAnswered;
+          m_prober->pending.erase(pitEntry->getName());
+        }
+    }
+  else if (pitInfo->origin == MyPitInfo::ORIGIN_PREFETCH)
+    {
+      if (m_prefetcher != nullptr)
+        {
+          ++m_prefetcher->nFetched;
+          m_prefetcher->pending.erase(pitEntry->getName());
+        }
+    }
+  else
+    {
+      ForwardingStats& stats = m_arms[pitInfo->arm].stats;
+      ++stats.nData;
+      stats.latency.add(delay);
+    }
+
+  if (m_shadow != nullptr && pitInfo->shadowFaceId != INVALID_FACEID)
+    {
+      m_shadow->activeLatency.add(delay);
+
+      // what the shadow's face would likely have taken
+      const milliseconds estimate = pitInfo->shadowFaceId == inFace.getId() ?
+        delay : getObservedDelay(*pitEntry, pitInfo->shadowFaceId);
+      if (estimate != milliseconds::zero())
+        {
+          m_shadow->estimatedLatency.add(estimate);
+          ++m_shadow->nJoined;
+        }
+    }
+
   auto& accessor = getMeasurements();
 
   // Update Face delay measurements and entry lifetimes owned
@@ -257,14 +697,17 @@ WeightedLoadBalancerStrategy::beforeSatisfyInterest(shared_ptr<pit::Entry> pitEn
       NFD_LOG_WARN ("accessor returned invalid measurements entry for " << pitEntry->getName());
     }
 
-  while (measurementsEntry != nullptr)
+  size_t nUpdated = 0;
+  while (measurementsEntry != nullptr &&
+         (m_tuning.propagationDepth == 0 || nUpdated < m_tuning.propagationDepth))
     {
       auto measurementsEntryInfo = measurementsEntry->getStrategyInfo<MyMeasurementInfo>();
 
       if (measurementsEntryInfo != nullptr)
         {
-          accessor.extendLifetime(*measurementsEntry, seconds(16));
-          measurementsEntryInfo->updateFaceDelay(inFace, delay);
+          accessor.extendLifetime(*measurementsEntry, m_tuning.measurementsLifetime);
+          measurementsEntryInfo->updateFaceDelay(inFace, delay, m_tuning.ewmaGain);
+          ++nUpdated;
         }
 
       measurementsEntry = accessor.getParent(*measurementsEntry);
@@ -275,6 +718,51 @@ WeightedLoadBalancerStrategy::beforeSatisfyInterest(shared_ptr<pit::Entry> pitEn
 void
 WeightedLoadBalancerStrategy::beforeExpirePendingInterest(shared_ptr<pit::Entry> pitEntry)
 {
+  auto pitInfo = pitEntry->getStrategyInfo<MyPitInfo>();
+  if (m_history != nullptr)
+    {
+      for (const auto& outRecord : pitEntry->getOutRecords())
+        ++m_history->getCounters(outRecord.getFace()->getId())->nTimeouts;
+
+      if (pitInfo != nullptr)
+        pitInfo->inFlight.reset();
+    }
+  if (pitInfo != nullptr && pitInfo->origin == MyPitInfo::ORIGIN_PREFETCH)
+    {
+      // most likely a segment past the end, which says nothing about the face
+      if (m_prefetcher != nullptr)
+        {
+          ++m_prefetcher->nTimeouts;
+          m_prefetcher->pending.erase(pitEntry->getName());
+        }
+      return;
+    }
+
+  if (pitInfo != nullptr && pitInfo->origin == MyPitInfo::ORIGIN_PROBE)
+    {
+      if (m_prober != nullptr)
+        {
+          ++m_prober->nTimeouts;
+          m_prober->pending.erase(pitEntry->getName());
+        }
+    }
+  else
+    {
+      if (m_recorder != nullptr)
+        m_recorder->recordExpire(*pitEntry);
+
+      if (pitInfo != nullptr)
+        ++m_arms[pitInfo->arm].stats.nTimeouts;
+    }
+
+  // only real timeouts are shared; a consumer retransmission demotes the
+  // faces for this process alone
+  if (m_sharedFaces != nullptr)
+    {
+      for (auto& outRecord : pitEntry->getOutRecords())
+        m_sharedFaces->recordFailure(*outRecord.getFace());
+    }
+
   demoteFace(pitEntry);
 }
 
@@ -292,12 +780,140 @@ isEligibleFace(const shared_ptr<pit::Entry>& pitEntry,
     !pitEntry->violatesScope(upstream);
 }
 
+/** \brief with \p isProbeGated, faces waiting for a probe are not eligible
+ */
+static inline bool
+isEligibleFace(const shared_ptr<pit::Entry>& pitEntry,
+               const Face& downstream,
+               const WeightedFace& upstream,
+               bool isProbeGated)
+{
+  return isEligibleFace(pitEntry, downstream, *upstream.face) &&
+    !(isProbeGated && upstream.needsProbe());
+}
+
+/** \brief latency curve of one face as a prefix sees it
+ */
+struct QueueCurve
+{
+  /// base delay in seconds
+  double delay;
+
+  /// Interests per second the face has left for the prefix
+  double capacity;
+
+  /// fraction of the prefix's Interests, set by splitLoad
+  double share;
+};
+
+/** \return Interests per second \p queue takes at \p level, the marginal
+ *          mean latency (OBJECTIVE_MEAN) or the p99 latency (OBJECTIVE_P99)
+ *          every used face is brought to
+ */
+static double
+getOfferedLoad(const QueueCurve& queue, double level, ModelObjective objective)
+{
+  // the sojourn time of M/M/1 is exponential with rate capacity - load
+  static const double LN_100 = std::log(100.0);
+
+  if (queue.capacity <= 0 || level <= queue.delay)
+    return 0;
+
+  // mean: d + c / (c - x)^2 = level, p99: d + ln(100) / (c - x) = level
+  const double load = objective == OBJECTIVE_MEAN ?
+                      queue.capacity - std::sqrt(queue.capacity / (level - queue.delay)) :
+                      queue.capacity - LN_100 / (level - queue.delay);
+  return std::max(0.0, load);
+}
+
+static double
+getOfferedLoad(const std::vector<QueueCurve>& queues, double level, ModelObjective objective)
+{
+  double load = 0;
+  for (const auto& queue : queues)
+    load += getOfferedLoad(queue, level, objective);
+  return load;
+}
+
+/** \brief set the shares of \p queues so that \p total Interests per
+ *         second have the lowest latency by \p objective
+ *
+ *  The level is found by bisection, since each queue's offered load grows
+ *  with it.
+ */
+static void
+splitLoad(std::vector<QueueCurve>& queues, double total, ModelObjective objective)
+{
+  // past this, the curves say little and any split is about as good
+  static const double MAX_UTILISATION = 0.95;
+  static const int N_BISECTIONS = 50;
+
+  double capacity = 0;
+  for (const auto& queue : queues)
+    capacity += std::max(0.0, queue.capacity);
+
+  if (capacity <= 0)
+    {
+      for (auto& queue : queues)
+        queue.share = 1.0 / queues.size();
+      return;
+    }
+
+  // with no load to split, no face is better than its capacity says
+  if (total <= 0 || total >= MAX_UTILISATION * capacity)
+    {
+      for (auto& queue : queues)
+        queue.share = std::max(0.0, queue.capacity) / capacity;
+      return;
+    }
+
+  double low = 0;
+  double high = 1;
+  while (getOfferedLoad(queues, high, objective) < total)
+    high *= 2;
+  for (int i = 0; i < N_BISECTIONS; ++i)
+    {
+      const double middle = (low + high) / 2;
+      if (getOfferedLoad(queues, middle, objective) < total)
+        low = middle;
+      else
+        high = middle;
+    }
+
+  const double load = getOfferedLoad(queues, high, objective);
+  for (auto& queue : queues)
+    queue.share = getOfferedLoad(queue, high, objective) / load;
+}
+
 shared_ptr<Face>
 WeightedLoadBalancerStrategy::selectOutgoingFace(const Face& inFace,
                                                  const Interest& interest,
                                                  shared_ptr<MyMeasurementInfo>& measurementsEntryInfo,
-                                                 shared_ptr<pit::Entry>& pitEntry)
+                                                 shared_ptr<pit::Entry>& pitEntry,
+                                                 const SelectionPolicy& policy,
+                                                 std::mt19937& randomGenerator,
+                                                 bool isShadow)
 {
+  const bool isProbeGated = m_prober != nullptr &&
+                            hasMeasuredFace(inFace, *measurementsEntryInfo, pitEntry);
+
+  if (policy.selector == SELECTOR_P2C)
+    return selectByPowerOfTwoChoices(inFace, measurementsEntryInfo, pitEntry,
+                                     policy.estimator, isProbeGated, randomGenerator);
+
+  const ModelAllocation* allocation = nullptr;
+  if (policy.selector == SELECTOR_MODEL && m_model != nullptr)
+    {
+      MyMeasurementInfo& info = *measurementsEntryInfo;
+      if (isShadow && info.shadowAllocation == nullptr)
+        info.shadowAllocation.reset(new ModelAllocation);
+
+      ModelAllocation& own = isShadow ? *info.shadowAllocation : info.allocation;
+      allocate(info, own);
+      if (own.isValid)
+        allocation = &own;
+    }
+
   auto& facesById =
     measurementsEntryInfo->weightedFaces->get<MyMeasurementInfo::ByFaceId>();
 
@@ -310,7 +926,10 @@ WeightedLoadBalancerStrategy::selectOutgoingFace(const Face& inFace,
   for (auto faceWeight : facesById)
     {
       faceIds.push_back(faceWeight.face->getId());
-      weights.push_back(faceWeight.weight);
+      weights.push_back(isProbeGated && faceWeight.needsProbe() ?
+                        0 : allocation != nullptr ? allocation->getShare(faceWeight.getId()) :
+                        faceWeight.getWeight(policy.estimator) *
+                        getLoadFactor(faceWeight.getId()));
     }
 
   faceIds.push_back(INVALID_FACEID);
@@ -319,7 +938,7 @@ WeightedLoadBalancerStrategy::selectOutgoingFace(const Face& inFace,
                                               faceIds.end(),
                                               weights.begin());
 
-  const uint64_t selection = dist(m_randomGenerator);
+  const uint64_t selection = dist(randomGenerator);
 
   NFD_LOG_DEBUG("selected value: " << selection);
 
@@ -330,7 +949,7 @@ WeightedLoadBalancerStrategy::selectOutgoingFace(const Face& inFace,
     {
       if (faceIds[i] <= selection && selection < faceIds[i + 1])
         {
-          if (isEligibleFace(pitEntry, inFace, *faceEntry->face))
+          if (isEligibleFace(pitEntry, inFace, *faceEntry, isProbeGated))
             {
               NFD_LOG_DEBUG("selected FaceID: " << faceEntry->face->getId());
               return faceEntry->face->shared_from_this();
@@ -345,7 +964,7 @@ WeightedLoadBalancerStrategy::selectOutgoingFace(const Face& inFace,
     }
 
   if (faceEntry != facesById.end() &&
-      isEligibleFace(pitEntry, inFace, *faceEntry->face))
+      isEligibleFace(pitEntry, inFace, *faceEntry, isProbeGated))
     {
       NFD_LOG_DEBUG("selected FaceID: " << faceEntry->face->getId());
       return faceEntry->face->shared_from_this();
@@ -357,7 +976,7 @@ WeightedLoadBalancerStrategy::selectOutgoingFace(const Face& inFace,
   const auto limit = std::min(firstMatchIndex, static_cast<uint64_t>(facesById.size()));
   for (uint64_t i = 0; i < limit; i++)
     {
-      if (isEligibleFace(pitEntry, inFace, *faceEntry->face))
+      if (isEligibleFace(pitEntry, inFace, *faceEntry, isProbeGated))
         {
           NFD_LOG_DEBUG("selected FaceID: " << faceEntry->face->getId());
           return faceEntry->face->shared_from_this();
@@ -371,11 +990,803 @@ WeightedLoadBalancerStrategy::selectOutgoingFace(const Face& inFace,
 }
 
 
-shared_ptr<MyPitInfo>
-WeightedLoadBalancerStrategy::myGetOrCreateMyPitInfo(const shared_ptr<pit::Entry>& entry)
+shared_ptr<Face>
+WeightedLoadBalancerStrategy::selectByPowerOfTwoChoices(const Face& inFace,
+                                                        shared_ptr<MyMeasurementInfo>& measurementsEntryInfo,
+                                                        shared_ptr<pit::Entry>& pitEntry,
+                                                        DelayEstimator estimator,
+                                                        bool isProbeGated,
+                                                        std::mt19937& randomGenerator)
 {
-  auto pitEntryInfo = entry->getStrategyInfo<MyPitInfo>();
-
+  auto& facesById =
+    measurementsEntryInfo->weightedFaces->get<MyMeasurementInfo::ByFaceId>();
+
+  std::vector<const WeightedFace*> eligible;
+  for (const auto& weightedFace : facesById)
+    {
+      if (isEligibleFace(pitEntry, inFace, weightedFace, isProbeGated))
+        eligible.push_back(&weightedFace);
+    }
+
+  if (eligible.empty())
+    {
+      NFD_LOG_WARN("no face selected for forwarding");
+      return nullptr;
+    }
+
+  if (eligible.size() == 1)
+    return eligible.front()->face;
+
+  // two distinct faces, the second drawn from the others
+  std::uniform_int_distribution<size_t> pickFirst(0, eligible.size() - 1);
+  std::uniform_int_distribution<size_t> pickSecond(0, eligible.size() - 2);
+  const size_t first = pickFirst(randomGenerator);
+  size_t second = pickSecond(randomGenerator);
+  if (second >= first)
+    ++second;
+
+  const WeightedFace* selected = eligible[first];
+  if (getLoadedDelay(*eligible[second], estimator) < getLoadedDelay(*selected, estimator))
+    selected = eligible[second];
+
+  NFD_LOG_DEBUG("selected FaceID: " << selected->getId());
+  return selected->face;
+}
+
+void
+WeightedLoadBalancerStrategy::sampleFaceLoads()
+{
+  static const double MIN_LOAD_FACTOR = 0.05;
+  static const uint64_t MIN_LOSS_SAMPLE = 10;
+
+  const double intervalSeconds = m_loadInterval.count() / 1000.0;
+
+  std::unordered_map<FaceId, FaceLoad> loads;
+  loads.reserve(m_faceLoads.size());
+  for (const auto& face : m_faceTable)
+    {
+      const FaceCounters& counters = face->getCounters();
+      FaceLoad load;
+      load.nOutInterests = counters.getNOutInterests();
+      load.nInData = counters.getNInDatas();
+      load.nInBytes = counters.getNInBytes();
+      load.nOutBytes = counters.getNOutBytes();
+
+      auto previous = m_faceLoads.find(face->getId());
+      if (previous == m_faceLoads.end())
+        {
+          auto capacity = m_linkCapacities.find(face->getRemoteUri().toString());
+          load.capacity = capacity == m_linkCapacities.end() ?
+                          m_defaultLinkCapacity : capacity->second;
+        }
+      else
+        {
+          const FaceLoad& before = previous->second;
+          load.capacity = before.capacity;
+
+          const double bits = 8.0 * std::max(load.nInBytes - before.nInBytes,
+                                             load.nOutBytes - before.nOutBytes);
+          const double utilisation = load.capacity > 0 ?
+                                     std::min(1.0, bits / intervalSeconds / load.capacity) : 0;
+
+          // Data lags its Interests by an RTT, so only busy intervals count
+          const uint64_t nSent = load.nOutInterests - before.nOutInterests;
+          const uint64_t nReceived = load.nInData - before.nInData;
+          const double lossRate = nSent < MIN_LOSS_SAMPLE ? before.lossRate :
+                                  std::max(0.0, 1.0 - static_cast<double>(nReceived) / nSent);
+
+          load.utilisation = before.utilisation + (utilisation - before.utilisation) / 4;
+          load.lossRate = before.lossRate + (lossRate - before.lossRate) / 4;
+          load.factor = std::max(MIN_LOAD_FACTOR,
+                                 (1 - load.utilisation) * (1 - load.lossRate));
+        }
+
+      loads[face->getId()] = load;
+    }
+  m_faceLoads.swap(loads);
+
+  m_loadSampling = scheduler::schedule(m_loadInterval,
+                                       bind(&WeightedLoadBalancerStrategy::sampleFaceLoads, this));
+}
+
+void
+WeightedLoadBalancerStrategy::fitLatencyModels()
+{
+  static const uint32_t MIN_SAMPLES = 4;
+  static const double GAIN = 0.25;
+  static const double BASE_DELAY_GAIN = 0.05;
+
+  // queueing delays below this, in seconds, are measurement noise
+  static const double MIN_QUEUEING = 1e-4;
+
+  const double intervalSeconds = m_model->interval.count() / 1000.0;
+  for (auto it = m_model->faces.begin(); it != m_model->faces.end(); )
+    {
+      if (getFace(it->first) == nullptr)
+        {
+          it = m_model->faces.erase(it);
+          continue;
+        }
+
+      LatencyModel::FaceModel& face = it->second;
+      face.load = face.nInterests / intervalSeconds;
+      if (face.nData >= MIN_SAMPLES)
+        {
+          // the base delay follows the lowest RTT down at once, and up slowly
+          if (face.baseDelay <= 0 || face.minRtt < face.baseDelay)
+            face.baseDelay = face.minRtt;
+          else
+            face.baseDelay += (face.minRtt - face.baseDelay) * BASE_DELAY_GAIN;
+
+          const double queueing = std::max(MIN_QUEUEING, face.rttSum / face.nData - face.baseDelay);
+          const double serviceRate = face.load + 1 / queueing;
+          face.serviceRate = face.serviceRate <= 0 ? serviceRate :
+                             face.serviceRate + (serviceRate - face.serviceRate) * GAIN;
+          ++m_model->nFits;
+        }
+
+      face.nInterests = 0;
+      face.nData = 0;
+      face.rttSum = 0;
+      face.minRtt = std::numeric_limits<double>::max();
+      ++it;
+    }
+
+  m_model->fitting = scheduler::schedule(m_model->interval,
+                                         bind(&WeightedLoadBalancerStrategy::fitLatencyModels,
+                                              this));
+}
+
+void
+WeightedLoadBalancerStrategy::allocate(const MyMeasurementInfo& measurementsEntryInfo,
+                                       ModelAllocation& allocation)
+{
+  const auto now = steady_clock::now();
+  if (now - allocation.time < m_model->interval)
+    return;
+
+  // per prefix, so that faces coming and going do not change the count
+  const uint64_t nForwarded = measurementsEntryInfo.nForwarded;
+  const bool isFirst = allocation.time == steady_clock::TimePoint();
+  const double elapsed = duration_cast<microseconds>(now - allocation.time).count() / 1e6;
+  const double rate = isFirst || nForwarded < allocation.nForwarded ? 0 :
+                      (nForwarded - allocation.nForwarded) / elapsed;
+  const ModelAllocation previous = allocation;
+
+  allocation.time = now;
+  allocation.nForwarded = nForwarded;
+  allocation.isValid = false;
+
+  // an idle interval says nothing about the split; the delay weights
+  // spread the first Interests until the rate is known
+  if (rate <= 0)
+    return;
+
+  auto& facesById = measurementsEntryInfo.weightedFaces->get<MyMeasurementInfo::ByFaceId>();
+
+  // quarantined faces get nothing; an unmeasured or unfitted one is left
+  // to the delay weights, which try it
+  std::vector<QueueCurve> queues;
+  std::vector<FaceId> faceIds;
+  queues.reserve(facesById.size());
+  faceIds.reserve(facesById.size());
+  for (const auto& weightedFace : facesById)
+    {
+      if (weightedFace.lastDelay == milliseconds::max())
+        continue;
+
+      auto model = m_model->faces.find(weightedFace.getId());
+      if (weightedFace.lastDelay == milliseconds::zero() || model == m_model->faces.end() ||
+          model->second.serviceRate <= 0)
+        return;
+
+      // the load of other prefixes is what this one did not plan to send
+      const double ownLoad = previous.isValid ? rate * previous.getShare(weightedFace.getId()) : 0;
+      const double otherLoad = std::max(0.0, model->second.load - ownLoad);
+      queues.push_back(QueueCurve{model->second.baseDelay,
+                                  model->second.serviceRate - otherLoad, 0});
+      faceIds.push_back(weightedFace.getId());
+    }
+  if (queues.empty())
+    return;
+
+  splitLoad(queues, rate, m_model->objective);
+
+  allocation.shares.clear();
+  for (size_t i = 0; i < queues.size(); ++i)
+    allocation.shares.emplace_back(faceIds[i], static_cast<float>(queues[i].share));
+  allocation.isValid = true;
+  ++m_model->nAllocations;
+}
+
+void
+WeightedLoadBalancerStrategy::applySharedFaces(MyMeasurementInfo& measurementsEntryInfo)
+{
+  auto& facesById = measurementsEntryInfo.weightedFaces->get<MyMeasurementInfo::ByFaceId>();
+  for (const auto& weightedFace : facesById)
+    {
+      if (m_sharedFaces->getVersion(*weightedFace.face) == weightedFace.sharedVersion)
+        continue;
+
+      SharedFaceTable::Snapshot snapshot;
+      if (!m_sharedFaces->read(*weightedFace.face, snapshot))
+        continue;
+      weightedFace.sharedVersion = snapshot.version;
+
+      // the face ID is unchanged, so the hashed index stays valid
+      if (snapshot.nConsecutiveFailures > 0 && weightedFace.lastDelay != milliseconds::max())
+        {
+          NFD_LOG_DEBUG("FaceId " << weightedFace.getId() << " failed in another process");
+          measurementsEntryInfo.updateFaceDelay(*weightedFace.face, milliseconds::max());
+        }
+      else if (snapshot.nConsecutiveFailures == 0 && snapshot.rtt > microseconds::zero() &&
+               weightedFace.needsProbe())
+        {
+          measurementsEntryInfo.updateFaceDelay(*weightedFace.face,
+                                                std::max(milliseconds(1),
+                                                         duration_cast<milliseconds>(snapshot.rtt)));
+        }
+    }
+}
+
+bool
+WeightedLoadBalancerStrategy::hasMeasuredFace(const Face& inFace,
+                                              const MyMeasurementInfo& measurementsEntryInfo,
+                                              const shared_ptr<pit::Entry>& pitEntry) const
+{
+  auto& facesById = measurementsEntryInfo.weightedFaces->get<MyMeasurementInfo::ByFaceId>();
+  return std::any_of(facesById.begin(), facesById.end(),
+                     [&] (const WeightedFace& weightedFace) {
+                       return !weightedFace.needsProbe() &&
+                              isEligibleFace(pitEntry, inFace, *weightedFace.face);
+                     });
+}
+
+void
+WeightedLoadBalancerStrategy::probeFaces(const fib::Entry& fibEntry,
+                                         const MyMeasurementInfo& measurementsEntryInfo,
+                                         const Face& inFace)
+{
+  m_prober->nExpired += sweepPending(m_prober->pending, m_prober->nextSweep);
+
+  const auto now = steady_clock::now();
+  for (const auto& weightedFace :
+         measurementsEntryInfo.weightedFaces->get<MyMeasurementInfo::ByFaceId>())
+    {
+      if (!weightedFace.needsProbe() || weightedFace.getId() == inFace.getId() ||
+          now - weightedFace.lastProbe < m_prober->interval)
+        continue;
+
+      weightedFace.lastProbe = now;
+
+      Name name = fibEntry.getPrefix();
+      name.append(m_prober->suffix).appendNumber(m_prober->nextSequence++);
+      // twice the lifetime, so that the PIT entry's expiry comes first
+      m_prober->pending[name] = PendingSynthetic{weightedFace.getId(),
+                                                 now + 2 * m_prober->lifetime};
+
+      Interest probe(name);
+      probe.setInterestLifetime(m_prober->lifetime);
+      probe.setMustBeFresh(true);
+
+      NFD_LOG_DEBUG("probing FaceId " << weightedFace.getId() << " with " << name);
+      expressSynthetic(probe);
+    }
+}
+
+void
+WeightedLoadBalancerStrategy::prefetchAfter(const Name& name,
+                                            const shared_ptr<fib::Entry>& fibEntry)
+{
+  static const uint64_t SEQUENTIAL_THRESHOLD = 2;
+  static const size_t MAX_FLOWS = 1024;
+
+  if (name.empty() || !name.get(-1).isSegment())
+    return;
+
+  const uint64_t segment = name.get(-1).toSegment();
+  const Name flowName = name.getPrefix(-1);
+
+  auto& flows = m_prefetcher->flows;
+  auto& idleFlows = m_prefetcher->idleFlows;
+  auto found = flows.find(flowName);
+  if (found == flows.end())
+    {
+      if (flows.size() >= MAX_FLOWS)
+        {
+          // forget the flow that has been idle longest
+          flows.erase(idleFlows.front());
+          idleFlows.pop_front();
+        }
+
+      Prefetcher::Flow& flow = flows[flowName];
+      flow.lastSegment = flow.highestSegment = segment;
+      flow.idlePosition = idleFlows.insert(idleFlows.end(), flowName);
+      return;
+    }
+
+  Prefetcher::Flow& flow = found->second;
+  idleFlows.splice(idleFlows.end(), idleFlows, flow.idlePosition);
+
+  // the Content Store answers the consumer's Interests for prefetched
+  // segments, so anything up to one past them continues the flow
+  if (segment > flow.lastSegment && segment <= flow.highestSegment + 1)
+    {
+      ++flow.nSequential;
+    }
+  else
+    {
+      if (flow.nSequential >= SEQUENTIAL_THRESHOLD)
+        ++m_prefetcher->nStopped;
+      flow.nSequential = 0;
+      flow.highestSegment = segment;
+    }
+  flow.lastSegment = segment;
+  flow.highestSegment = std::max(flow.highestSegment, segment);
+
+  if (flow.nSequential < SEQUENTIAL_THRESHOLD)
+    return;
+
+  // the measured face with the lowest delay; unmeasured faces sort first
+  auto measurementsEntryInfo = myGetOrCreateMyMeasurementInfo(fibEntry);
+  measurementsEntryInfo->updateStoredNextHops(fibEntry->getNextHops());
+  const WeightedFace* best = nullptr;
+  for (const auto& weightedFace : measurementsEntryInfo->weightedFaces->get<MyMeasurementInfo::ByDelay>())
+    {
+      if (!weightedFace.needsProbe())
+        {
+          best = &weightedFace;
+          break;
+        }
+    }
+  if (best == nullptr)
+    return;
+
+  // prefetches are the first traffic to go under load
+  if (m_loadShedder.isEnabled() && m_loadShedder.isAboveLow(m_pit.size(), *m_nPendingInterests))
+    return;
+
+  m_prefetcher->nExpired += sweepPending(m_prefetcher->pending, m_prefetcher->nextSweep);
+
+  const auto now = steady_clock::now();
+  const uint64_t last = std::min(segment + m_prefetcher->depth, flow.finalSegment);
+  for (uint64_t next = flow.highestSegment + 1;
+       next <= last && m_prefetcher->pending.size() < m_prefetcher->budget; ++next)
+    {
+      // speculative like a retransmission, so it draws from the same budget
+      if (!m_retryBudget.tryWithdraw())
+        break;
+
+      Interest prefetch(Name(flowName).appendSegment(next));
+      prefetch.setInterestLifetime(ndn::DEFAULT_INTEREST_LIFETIME);
+      m_prefetcher->pending[prefetch.getName()] =
+        PendingSynthetic{best->getId(), now + 2 * ndn::DEFAULT_INTEREST_LIFETIME};
+      flow.highestSegment = next;
+
+      expressSynthetic(prefetch);
+    }
+}
+
+size_t
+WeightedLoadBalancerStrategy::sweepPending(PendingSyntheticMap& pending,
+                                           steady_clock::TimePoint& nextSweep)
+{
+  const auto now = steady_clock::now();
+  if (now < nextSweep)
+    return 0;
+  nextSweep = now + seconds(1);
+
+  size_t nSwept = 0;
+  for (auto it = pending.begin(); it != pending.end(); )
+    {
+      if (it->second.deadline <= now)
+        {
+          it = pending.erase(it);
+          ++nSwept;
+        }
+      else
+        {
+          ++it;
+        }
+    }
+  return nSwept;
+}
+
+void
+WeightedLoadBalancerStrategy::noteFinalSegment(const Data& data)
+{
+  const Name& name = data.getName();
+  if (name.empty() || !name.get(-1).isSegment() || !data.getFinalBlockId().isSegment())
+    return;
+
+  auto found = m_prefetcher->flows.find(name.getPrefix(-1));
+  if (found != m_prefetcher->flows.end())
+    found->second.finalSegment = data.getFinalBlockId().toSegment();
+}
+
+void
+WeightedLoadBalancerStrategy::expressSynthetic(const Interest& interest)
+{
+  if (m_syntheticFace == nullptr)
+    {
+      m_syntheticFace = make_shared<SyntheticFace>();
+      m_faceTable.add(m_syntheticFace);
+    }
+
+  // it runs through a pipeline of its own, after this one
+  weak_ptr<SyntheticFace> syntheticFace = m_syntheticFace;
+  getGlobalIoService().post([syntheticFace, interest] {
+      auto face = syntheticFace.lock();
+      if (face != nullptr)
+        face->expressInterest(interest);
+    });
+}
+
+void
+WeightedLoadBalancerStrategy::forwardSynthetic(const Interest& interest,
+                                               shared_ptr<pit::Entry> pitEntry)
+{
+  const Name& name = interest.getName();
+  if (pitEntry->getStrategyInfo<MyPitInfo>() != nullptr)
+    {
+      // a consumer asked first, and its Interest is on its way
+      if (m_prober != nullptr)
+        m_prober->pending.erase(name);
+      if (m_prefetcher != nullptr)
+        m_prefetcher->pending.erase(name);
+      return;
+    }
+
+  auto pitEntryInfo = myGetOrCreateMyPitInfo(pitEntry);
+  pitEntryInfo->origin = MyPitInfo::ORIGIN_PROBE;
+
+  PendingSyntheticMap* pending = nullptr;
+  if (m_prober != nullptr && m_prober->pending.count(name) > 0)
+    {
+      pending = &m_prober->pending;
+    }
+  else if (m_prefetcher != nullptr && m_prefetcher->pending.count(name) > 0)
+    {
+      pitEntryInfo->origin = MyPitInfo::ORIGIN_PREFETCH;
+      pending = &m_prefetcher->pending;
+    }
+
+  shared_ptr<Face> face = pending == nullptr ? nullptr : getFace(pending->at(name).faceId);
+  if (face == nullptr)
+    {
+      // the face went away before the Interest left
+      rejectPendingInterest(pitEntry);
+      return;
+    }
+
+  if (pitEntryInfo->origin == MyPitInfo::ORIGIN_PREFETCH)
+    ++m_prefetcher->nSent;
+  else
+    ++m_prober->nSent;
+
+  if (m_history != nullptr)
+    {
+      auto counters = m_history->getCounters(face->getId());
+      ++counters->nInterests;
+      pitEntryInfo->inFlight.reset(new StrategyHistory::InFlight(face->getId(), counters));
+    }
+  if (m_model != nullptr)
+    m_model->countInterest(face->getId());
+  sendInterest(pitEntry, face);
+}
+
+void
+WeightedLoadBalancerStrategy::evaluateShadow(const Face& inFace,
+                                             const Interest& interest,
+                                             shared_ptr<MyMeasurementInfo>& measurementsEntryInfo,
+                                             shared_ptr<pit::Entry>& pitEntry,
+                                             MyPitInfo& pitEntryInfo,
+                                             const shared_ptr<Face>& selectedFace)
+{
+  const auto start = std::chrono::steady_clock::now();
+  auto shadowFace = selectOutgoingFace(inFace, interest, measurementsEntryInfo, pitEntry,
+                                       m_shadow->policy, m_shadow->randomGenerator, true);
+  m_shadow->selectionNs +=
+    std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  ++m_shadow->nDecisions;
+  if (shadowFace == selectedFace)
+    ++m_shadow->nAgreements;
+
+  if (selectedFace != nullptr)
+    ++m_shadow->load[selectedFace->getId()].first;
+
+  if (shadowFace != nullptr)
+    {
+      ++m_shadow->load[shadowFace->getId()].second;
+      pitEntryInfo.shadowFaceId = shadowFace->getId();
+    }
+}
+
+milliseconds
+WeightedLoadBalancerStrategy::getObservedDelay(const pit::Entry& pitEntry, FaceId faceId)
+{
+  MeasurementsAccessor& accessor = this->getMeasurements();
+  for (auto measurementsEntry = accessor.get(pitEntry); measurementsEntry != nullptr;
+       measurementsEntry = accessor.getParent(*measurementsEntry))
+    {
+      auto measurementsEntryInfo = measurementsEntry->getStrategyInfo<MyMeasurementInfo>();
+      if (measurementsEntryInfo == nullptr)
+        continue;
+
+      auto& facesById = measurementsEntryInfo->weightedFaces->get<MyMeasurementInfo::ByFaceId>();
+      auto weightedFace = facesById.find(faceId);
+      if (weightedFace != facesById.end() && weightedFace->lastDelay != milliseconds::max())
+        return weightedFace->lastDelay;
+    }
+
+  return milliseconds::zero();
+}
+
+size_t
+WeightedLoadBalancerStrategy::selectArm(const Name& name) const
+{
+  if (m_arms.size() < 2)
+    return 0;
+
+  // FNV-1a over the encoded name, so a name always lands in the same arm
+  const Block& wire = name.wireEncode();
+  uint64_t hash = 14695981039346656037ULL;
+  for (const uint8_t* byte = wire.wire(); byte != wire.wire() + wire.size(); ++byte)
+    {
+      hash ^= *byte;
+      hash *= 1099511628211ULL;
+    }
+
+  return (hash % 10000) < m_candidateFraction * 10000 ? 1 : 0;
+}
+
+void
+WeightedLoadBalancerStrategy::writeStats(std::ostream& os)
+{
+  os << "{\"arms\": {";
+  for (size_t i = 0; i < m_arms.size(); ++i)
+    {
+      const Arm& arm = m_arms[i];
+      const double fraction = i == 0 ? 1 - m_candidateFraction : m_candidateFraction;
+
+      os << (i > 0 ? ", " : "") << "\"" << arm.label << "\": {"
+         << "\"selector\": \"" << toString(arm.policy.selector) << "\""
+         << ", \"estimator\": \"" << toString(arm.policy.estimator) << "\""
+         << ", \"fraction\": " << fraction << ", ";
+      arm.stats.writeJsonMembers(os);
+      os << "}";
+    }
+  os << "}, \"retry_budget\": ";
+  m_retryBudget.writeJson(os);
+  os << ", \"shedding\": ";
+  m_loadShedder.writeJson(os, m_pit.size(), *m_nPendingInterests);
+  os << ", \"handoff\": ";
+  MeasurementRecordStore::getInstance().writeJson(os);
+
+  if (m_prefetcher != nullptr)
+    {
+      os << ", \"prefetch\": {"
+         << "\"depth\": " << m_prefetcher->depth
+         << ", \"flows\": " << m_prefetcher->flows.size()
+         << ", \"sent\": " << m_prefetcher->nSent
+         << ", \"fetched\": " << m_prefetcher->nFetched
+         << ", \"timeouts\": " << m_prefetcher->nTimeouts
+         << ", \"joined\": " << m_prefetcher->nJoined
+         << ", \"stopped\": " << m_prefetcher->nStopped
+         << ", \"expired\": " << m_prefetcher->nExpired
+         << ", \"pending\": " << m_prefetcher->pending.size() << "}";
+    }
+
+  if (m_loadInterval > milliseconds::zero())
+    {
+      os << ", \"load\": {";
+      for (auto it = m_faceLoads.begin(); it != m_faceLoads.end(); ++it)
+        {
+          os << (it != m_faceLoads.begin() ? ", " : "") << "\"" << it->first << "\": "
+             << "{\"utilisation\": " << it->second.utilisation
+             << ", \"loss\": " << it->second.lossRate
+             << ", \"factor\": " << it->second.factor << "}";
+        }
+      os << "}";
+    }
+
+  if (m_model != nullptr)
+    {
+      os << ", \"model\": {"
+         << "\"objective\": \"" << toString(m_model->objective) << "\""
+         << ", \"fits\": " << m_model->nFits
+         << ", \"allocations\": " << m_model->nAllocations
+         << ", \"faces\": {";
+      for (auto it = m_model->faces.begin(); it != m_model->faces.end(); ++it)
+        {
+          os << (it != m_model->faces.begin() ? ", " : "") << "\"" << it->first << "\": "
+             << "{\"base_delay_ms\": " << it->second.baseDelay * 1000
+             << ", \"service_rate\": " << it->second.serviceRate
+             << ", \"load\": " << it->second.load << "}";
+        }
+      os << "}}";
+    }
+
+  if (m_prober != nullptr)
+    {
+      os << ", \"probes\": {"
+         << "\"sent\": " << m_prober->nSent
+         << ", \"answered\": " << m_prober->nAnswered
+         << ", \"timeouts\": " << m_prober->nTimeouts
+         << ", \"expired\": " << m_prober->nExpired
+         << ", \"pending\": " << m_prober->pending.size() << "}";
+    }
+
+  if (m_shadow != nullptr)
+    {
+      const Shadow& shadow = *m_shadow;
+      const double nDecisions = std::max<uint64_t>(shadow.nDecisions, 1);
+
+      os << ", \"shadow\": {"
+         << "\"selector\": \"" << toString(shadow.policy.selector) << "\""
+         << ", \"estimator\": \"" << toString(shadow.policy.estimator) << "\""
+         << ", \"decisions\": " << shadow.nDecisions
+         << ", \"agreement\": " << shadow.nAgreements / nDecisions
+         << ", \"joined\": " << shadow.nJoined
+         << ", \"cpu_ns_per_decision\": " << shadow.selectionNs / nDecisions
+         << ", \"active_cpu_ns_per_decision\": " << shadow.activeSelectionNs / nDecisions
+         << ", \"active_latency_ms\": ";
+      shadow.activeLatency.writeJson(os);
+      os << ", \"estimated_latency_ms\": ";
+      shadow.estimatedLatency.writeJson(os);
+
+      os << ", \"load\": {";
+      for (auto it = shadow.load.begin(); it != shadow.load.end(); ++it)
+        {
+          os << (it != shadow.load.begin() ? ", " : "") << "\"" << it->first << "\": "
+             << "{\"active\": " << it->second.first / nDecisions
+             << ", \"shadow\": " << it->second.second / nDecisions << "}";
+        }
+      os << "}}";
+    }
+  os << "}";
+}
+
+void
+WeightedLoadBalancerStrategy::inspect(const std::vector<std::string>& arguments,
+                                      const StrategyControl::ReplyCallback& done)
+{
+  if (arguments.size() > 1)
+    throw std::invalid_argument("usage: inspect [PREFIX]");
+
+  const Name prefix = arguments.empty() ? Name() : Name(arguments[0]);
+
+  auto inspection = make_shared<Inspection>();
+  inspection->done = done;
+  inspection->reply << "{\"prefixes\": [";
+
+  // the measured prefix PREFIX falls under comes first, then those below it
+  auto governing = m_nameTree.findLongestPrefixMatch(prefix,
+    [] (const name_tree::Entry& entry) {
+      return getMeasurementInfo(entry) != nullptr;
+    });
+  auto root = m_nameTree.findExactMatch(prefix);
+  if (governing != nullptr && governing != root)
+    inspectEntry(*inspection, *governing);
+  if (root != nullptr)
+    inspection->stack.emplace_back(root, 0);
+
+  m_inspections.push_back(inspection);
+  continueInspection(inspection);
+}
+
+void
+WeightedLoadBalancerStrategy::continueInspection(const shared_ptr<Inspection>& inspection)
+{
+  auto& stack = inspection->stack;
+  for (size_t nVisited = 0; !stack.empty() && nVisited < INSPECTION_SLICE; )
+    {
+      auto& top = stack.back();
+      if (top.second == 0)
+        {
+          inspectEntry(*inspection, *top.first);
+          ++nVisited;
+        }
+
+      auto& children = top.first->getChildren();
+      if (top.second < children.size())
+        {
+          auto child = children[top.second++];
+          stack.emplace_back(child, 0);
+        }
+      else
+        {
+          stack.pop_back();
+        }
+    }
+
+  if (!stack.empty())
+    {
+      // forwarding goes on between slices; the strategy may be gone by the next one
+      weak_ptr<Inspection> next = inspection;
+      getGlobalIoService().post([this, next] {
+          auto inspection = next.lock();
+          if (inspection != nullptr)
+            continueInspection(inspection);
+        });
+      return;
+    }
+
+  inspection->reply << "]}";
+  m_inspections.remove(inspection);
+  inspection->done(inspection->reply.str());
+}
+
+void
+WeightedLoadBalancerStrategy::inspectEntry(Inspection& inspection,
+                                           const name_tree::Entry& entry) const
+{
+  auto measurementsEntryInfo = getMeasurementInfo(entry);
+  if (measurementsEntryInfo == nullptr ||
+      &m_strategyChoice.findEffectiveStrategy(entry.getPrefix()) != this)
+    return;
+
+  const DelayEstimator estimator = m_arms.front().policy.estimator;
+  auto& facesById = measurementsEntryInfo->weightedFaces->get<MyMeasurementInfo::ByFaceId>();
+
+  double totalWeight = 0;
+  uint64_t nForwarded = 0;
+  for (const auto& weightedFace : facesById)
+    {
+      totalWeight += weightedFace.getWeight(estimator) * getLoadFactor(weightedFace.getId());
+      nForwarded += weightedFace.nForwarded;
+    }
+
+  auto writeDelay = [] (std::ostream& os, const milliseconds& delay) {
+    if (delay == milliseconds::zero() || delay == milliseconds::max())
+      os << "null";
+    else
+      os << delay.count();
+  };
+
+  std::ostream& os = inspection.reply;
+  os << (inspection.nPrefixes++ > 0 ? ",\n" : "\n") << "{\"prefix\": ";
+  writeJsonString(os, entry.getPrefix().toUri());
+  os << ", \"faces\": [";
+  for (auto it = facesById.begin(); it != facesById.end(); ++it)
+    {
+      const WeightedFace& weightedFace = *it;
+      const char* health = weightedFace.lastDelay == milliseconds::zero() ? "unmeasured" :
+                           weightedFace.lastDelay == milliseconds::max() ? "quarantined" :
+                           "healthy";
+      const double weight = weightedFace.getWeight(estimator) *
+                            getLoadFactor(weightedFace.getId());
+
+      os << (it != facesById.begin() ? ", " : "")
+         << "{\"face\": " << weightedFace.getId()
+         << ", \"health\": \"" << health << "\""
+         << ", \"last_delay_ms\": ";
+      writeDelay(os, weightedFace.lastDelay);
+      os << ", \"smoothed_delay_ms\": ";
+      writeDelay(os, weightedFace.smoothedDelay);
+      os << ", \"weight\": " << (totalWeight > 0 ? weight / totalWeight : 0)
+         << ", \"in_flight\": ";
+      if (m_history != nullptr)
+        os << (weightedFace.history == nullptr ? 0 : weightedFace.history->nInFlight);
+      else
+        os << "null";
+      if (m_model != nullptr && measurementsEntryInfo->allocation.isValid)
+        os << ", \"allocation\": "
+           << measurementsEntryInfo->allocation.getShare(weightedFace.getId());
+      os << ", \"forwarded\": " << weightedFace.nForwarded
+         << ", \"share\": "
+         << (nForwarded > 0 ? static_cast<double>(weightedFace.nForwarded) / nForwarded : 0)
+         << "}";
+    }
+  os << "]}";
+}
+
+shared_ptr<MyPitInfo>
+WeightedLoadBalancerStrategy::myGetOrCreateMyPitInfo(const shared_ptr<pit::Entry>& entry)
+{
+  auto pitEntryInfo = entry->getStrategyInfo<MyPitInfo>();
+
   if (pitEntryInfo == nullptr)
     {
       pitEntryInfo = make_shared<MyPitInfo>();
@@ -401,6 +1812,21 @@ WeightedLoadBalancerStrategy::myGetOrCreateMyMeasurementInfo(const shared_ptr<fi
     {
       measurementsEntryInfo = make_shared<MyMeasurementInfo>();
       measurementsEntry->setStrategyInfo(measurementsEntryInfo);
+
+      // pick up where the previous strategy of the namespace left off
+      if (m_isHandoffEnabled)
+        {
+          const Name& prefix = measurementsEntry->getName();
+          measurementsEntryInfo->exportEntry = measurementsEntry;
+
+          auto record = MeasurementRecordStore::getInstance().take(prefix);
+          if (record != nullptr &&
+              measurementsEntryInfo->importRecord(*record, entry->getNextHops()))
+            {
+              NFD_LOG_DEBUG("imported " << record->faces.size() << " face estimates for "
+                            << prefix);
+            }
+        }
     }
 
   return measurementsEntryInfo;
@@ -409,22 +1835,31 @@ WeightedLoadBalancerStrategy::myGetOrCreateMyMeasurementInfo(const shared_ptr<fi
 void
 WeightedLoadBalancerStrategy::demoteFace(shared_ptr<pit::Entry> pitEntry)
 {
+  if (m_history != nullptr)
+    {
+      for (auto& outRecord : pitEntry->getOutRecords())
+        ++m_history->getCounters(outRecord.getFace()->getId())->nDemotions;
+    }
+
   MeasurementsAccessor& accessor = this->getMeasurements();
   auto measurementsEntry = accessor.get(*pitEntry);
 
-  while (measurementsEntry != nullptr)
+  size_t nUpdated = 0;
+  while (measurementsEntry != nullptr &&
+         (m_tuning.propagationDepth == 0 || nUpdated < m_tuning.propagationDepth))
     {
       auto measurementsEntryInfo =
         measurementsEntry->getStrategyInfo<MyMeasurementInfo>();
 
       if (measurementsEntryInfo != nullptr)
         {
-          accessor.extendLifetime(*measurementsEntry, seconds(16));
+          accessor.extendLifetime(*measurementsEntry, m_tuning.measurementsLifetime);
           for (auto& entry : pitEntry->getOutRecords())
             {
               measurementsEntryInfo->updateFaceDelay(*(entry.getFace()),
                                                      milliseconds::max());
             }
+          ++nUpdated;
         }
 
       measurementsEntry = accessor.getParent(*measurementsEntry);
@@ -436,7 +1871,7 @@ WeightedLoadBalancerStrategy::demoteFace(shared_ptr<pit::Entry> pitEntry)
 ///////////////////////////////////////
 
 void
-MyMeasurementInfo::updateFaceDelay(const Face& face, const milliseconds& delay)
+MyMeasurementInfo::updateFaceDelay(const Face& face, const milliseconds& delay, double gain)
 {
   auto& facesById = weightedFaces->get<MyMeasurementInfo::ByFaceId>();
   auto faceEntry = facesById.find(face.getId());
@@ -451,37 +1886,117 @@ MyMeasurementInfo::updateFaceDelay(const Face& face, const milliseconds& delay)
       auto result = facesById.modify(faceEntry,
                                      bind(&WeightedFace::modifyWeightedFaceDelay,
                                           _1,
-                                          boost::cref(delay)));
+                                          boost::cref(delay),
+                                          gain));
 
       NFD_LOG_DEBUG("updated weight: " << oldWeight << " -> " << faceEntry->weight
                     << " modify: " << result << "\n");
     }
 }
 
+MyMeasurementInfo::~MyMeasurementInfo()
+{
+  --s_nLive;
+
+  // the entry is gone when it expired, and outlives the info when its
+  // strategy changed
+  auto entry = exportEntry.lock();
+  if (entry != nullptr && !weightedFaces->empty())
+    MeasurementRecordStore::getInstance().save(exportRecord(entry->getName()));
+}
+
+MeasurementRecord
+MyMeasurementInfo::exportRecord(const Name& prefix) const
+{
+  MeasurementRecord record;
+  record.prefix = prefix;
+  record.exportTime = steady_clock::now();
+  record.faces.reserve(weightedFaces->size());
+  for (const auto& weightedFace : *weightedFaces)
+    {
+      record.faces.push_back(MeasurementRecord::FaceEstimate{weightedFace.getId(),
+                                                             weightedFace.lastDelay,
+                                                             weightedFace.smoothedDelay});
+    }
+  return record;
+}
+
+bool
+MyMeasurementInfo::importRecord(const MeasurementRecord& record,
+                                const fib::NextHopList& nexthops)
+{
+  if (record.version != MeasurementRecord::CURRENT_VERSION)
+    return false;
+
+  auto& facesById = weightedFaces->get<MyMeasurementInfo::ByFaceId>();
+  for (const auto& hop : nexthops)
+    {
+      const FaceId faceId = hop.getFace()->getId();
+      auto estimate = std::find_if(record.faces.begin(), record.faces.end(),
+                                   [faceId] (const MeasurementRecord::FaceEstimate& face) {
+                                     return face.faceId == faceId;
+                                   });
+      if (estimate == record.faces.end() || facesById.count(faceId) > 0)
+        continue;
+
+      WeightedFace weightedFace(hop.getFace(), estimate->lastDelay);
+      weightedFace.smoothedDelay = estimate->smoothedDelay;
+      facesById.insert(weightedFace);
+    }
+  return true;
+}
+
+bool
+MyMeasurementInfo::hasHealthyFace() const
+{
+  // demoted faces sort last by delay
+  auto& byDelay = weightedFaces->get<MyMeasurementInfo::ByDelay>();
+  return !byDelay.empty() && byDelay.begin()->lastDelay != milliseconds::max();
+}
+
 void
 MyMeasurementInfo::updateStoredNextHops(const fib::NextHopList& nexthops)
 {
-  auto updatedFaceSet = new MyMeasurementInfo::WeightedFaceSet;
   auto& facesById = weightedFaces->get<MyMeasurementInfo::ByFaceId>();
-  auto& updatedFacesById = updatedFaceSet->get<MyMeasurementInfo::ByFaceId>();
 
+  // common case: same nexthops as for the previous Interest
+  if (facesById.size() == nexthops.size() &&
+      std::all_of(nexthops.begin(), nexthops.end(),
+                  [&facesById] (const fib::NextHop& hop) {
+                    return facesById.count(hop.getFace()->getId()) > 0;
+                  }))
+    {
+      return;
+    }
+
+  std::vector<FaceId> nexthopIds;
+  nexthopIds.reserve(nexthops.size());
   for (auto& hop : nexthops)
     {
       BOOST_ASSERT(hop.getFace() != nullptr);
-      auto& face = hop.getFace();
+      nexthopIds.push_back(hop.getFace()->getId());
+    }
+  std::sort(nexthopIds.begin(), nexthopIds.end());
 
-      auto weightedIt = facesById.find(face->getId());
-      if (weightedIt == facesById.end())
-        {
-          updatedFacesById.insert(WeightedFace(face));
-        }
+  // drop faces that are no longer nexthops, keeping the others in place
+  for (auto it = facesById.begin(); it != facesById.end(); )
+    {
+      if (std::binary_search(nexthopIds.begin(), nexthopIds.end(), it->getId()))
+        ++it;
       else
+        it = facesById.erase(it);
+    }
+
+  for (auto& hop : nexthops)
+    {
+      if (facesById.count(hop.getFace()->getId()) == 0)
         {
-          updatedFacesById.insert(*weightedIt);
+          facesById.insert(WeightedFace(hop.getFace()));
+          allocation.isValid = false;
+          if (shadowAllocation != nullptr)
+            shadowAllocation->isValid = false;
         }
     }
-
-  weightedFaces.reset(updatedFaceSet);
 }
 
 } // namespace fw
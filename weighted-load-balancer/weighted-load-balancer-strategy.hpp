@@ -27,14 +27,358 @@
 #ifndef NFD_DAEMON_FW_WEIGHTED_LOAD_BALANCER_STRATEGY_HPP
 #define NFD_DAEMON_FW_WEIGHTED_LOAD_BALANCER_STRATEGY_HPP
 
+#include <limits>
+#include <list>
+#include <sstream>
+#include <unordered_map>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/mem_fun.hpp>
+
 #include "strategy.hpp"
 #include "retx-suppression-exponential.hpp"
+#include "retry-budget.hpp"
+#include "load-shedder.hpp"
+#include "shared-face-table.hpp"
+#include "measurement-record.hpp"
+#include "strategy-recorder.hpp"
+#include "strategy-control.hpp"
+#include "strategy-history.hpp"
+#include "strategy-parameters.hpp"
+#include "strategy-stats.hpp"
+
+#include "core/logger.hpp"
+#include "core/scheduler.hpp"
 
 namespace nfd {
 namespace fw {
 
-class MyPitInfo;
-class MyMeasurementInfo;
+/** \brief how the delay of a face is estimated from its samples
+ */
+enum DelayEstimator {
+  ESTIMATOR_LAST, ///< the last sample
+  ESTIMATOR_EWMA  ///< moving average, gain 1/8 by default, restarted after a timeout
+};
+
+/** \brief how the upstream is picked among the nexthops
+ */
+enum FaceSelector {
+  SELECTOR_WEIGHTED, ///< at random, weighted by estimated delay
+  SELECTOR_P2C,      ///< the faster of two faces picked at random
+  SELECTOR_MODEL     ///< at random, by the split a latency model predicts best
+};
+
+/** \brief what the split of SELECTOR_MODEL minimises
+ */
+enum ModelObjective {
+  OBJECTIVE_MEAN, ///< mean latency of the prefix
+  OBJECTIVE_P99   ///< highest 99th percentile latency among the faces used
+};
+
+struct SelectionPolicy
+{
+  FaceSelector selector;
+  DelayEstimator estimator;
+};
+
+class WeightedFace
+{
+public:
+
+  WeightedFace(shared_ptr<Face> face_,
+               const time::milliseconds& delay = time::milliseconds(0))
+    : face(face_)
+    , lastDelay(delay)
+    , smoothedDelay(delay)
+  {
+    calculateWeight();
+  }
+
+  bool
+  operator<(const WeightedFace& other) const
+  {
+    if (lastDelay == other.lastDelay)
+      return face->getId() < other.face->getId();
+
+    return lastDelay < other.lastDelay;
+  }
+
+  FaceId
+  getId() const
+  {
+    return face->getId();
+  }
+
+  static void
+  modifyWeightedFaceDelay(WeightedFace& weightedFace,
+                          const time::milliseconds& delay,
+                          double gain)
+  {
+    auto& smoothed = weightedFace.smoothedDelay;
+    if (delay == time::milliseconds::max() || smoothed == time::milliseconds::max() ||
+        smoothed == time::milliseconds::zero())
+      smoothed = delay;
+    else
+      smoothed += time::duration_cast<time::milliseconds>((delay - smoothed) * gain);
+
+    weightedFace.lastDelay = delay;
+    weightedFace.calculateWeight();
+  }
+
+  void
+  calculateWeight()
+  {
+    weight = (1.0 * (time::milliseconds::max() - lastDelay)) / time::milliseconds::max();
+  }
+
+  const time::milliseconds&
+  getDelay(DelayEstimator estimator) const
+  {
+    return estimator == ESTIMATOR_EWMA ? smoothedDelay : lastDelay;
+  }
+
+  double
+  getWeight(DelayEstimator estimator) const
+  {
+    if (estimator == ESTIMATOR_LAST)
+      return weight;
+
+    return (1.0 * (time::milliseconds::max() - smoothedDelay)) / time::milliseconds::max();
+  }
+
+  /** \return whether the face is new or quarantined after a timeout
+   */
+  bool
+  needsProbe() const
+  {
+    return lastDelay == time::milliseconds::zero() || lastDelay == time::milliseconds::max();
+  }
+
+  shared_ptr<Face> face;
+  time::milliseconds lastDelay;
+  time::milliseconds smoothedDelay;
+  double weight;
+
+  /// not part of any index
+  mutable time::steady_clock::TimePoint lastProbe;
+  mutable uint32_t sharedVersion = 0;
+
+  /// Interests of the prefix sent to the face, for its realised share
+  mutable uint64_t nForwarded = 0;
+
+  /// the face's history counters, taken when it is first forwarded to
+  mutable shared_ptr<StrategyHistory::FaceCounters> history;
+};
+
+/** \brief the face the strategy's own Interests, probes and prefetches,
+ *         enter the forwarder from
+ */
+class SyntheticFace : public Face
+{
+public:
+  SyntheticFace()
+    : Face(FaceUri("null://"), FaceUri("null://"), true)
+  {
+  }
+
+  void
+  expressInterest(const Interest& interest)
+  {
+    if (getId() != INVALID_FACEID)
+      this->emitSignal(onReceiveInterest, interest);
+  }
+
+  virtual void
+  sendInterest(const Interest& interest) DECL_OVERRIDE
+  {
+  }
+
+  /// the strategy takes results from the PIT entry, and prefetched Data
+  /// from the Content Store
+  virtual void
+  sendData(const Data& data) DECL_OVERRIDE
+  {
+  }
+
+  virtual void
+  close() DECL_OVERRIDE
+  {
+    this->fail("close");
+  }
+};
+
+///////////////////////
+// PIT entry storage //
+///////////////////////
+
+class MyPitInfo : public StrategyInfo
+{
+public:
+  MyPitInfo()
+    : creationTime(time::system_clock::now())
+  {
+    ++s_nLive;
+  }
+
+  virtual
+  ~MyPitInfo()
+  {
+    --s_nLive;
+  }
+
+  static int constexpr
+  getTypeId() { return 9970; }
+
+  time::system_clock::TimePoint creationTime;
+
+  /// experiment arm the Interest was assigned to
+  size_t arm = 0;
+
+  /// face the shadow selector would have forwarded to
+  FaceId shadowFaceId = INVALID_FACEID;
+
+  enum Origin {
+    ORIGIN_DOWNSTREAM,
+    ORIGIN_PROBE,
+    ORIGIN_PREFETCH
+  };
+
+  /// who sent the Interest: a downstream, or the strategy itself
+  Origin origin = ORIGIN_DOWNSTREAM;
+
+  /// counts the entry among the strategy's pending Interests
+  unique_ptr<PendingInterestToken> pending;
+
+  /// counts the entry in flight to the face it was last sent to, with history
+  unique_ptr<StrategyHistory::InFlight> inFlight;
+
+  static size_t s_nLive;
+};
+
+///////////////////////////////
+// Measurement entry storage //
+///////////////////////////////
+
+/** \brief split of a prefix's Interests among its faces, computed by
+ *         SELECTOR_MODEL once per model interval
+ */
+struct ModelAllocation
+{
+  /** \return fraction of the Interests planned for \p faceId
+   */
+  float
+  getShare(FaceId faceId) const
+  {
+    for (const auto& share : shares)
+      {
+        if (share.first == faceId)
+          return share.second;
+      }
+    return 0;
+  }
+
+  /// false while a face has no curve yet, or after the faces changed
+  bool isValid = false;
+
+  /// when it was computed, and the prefix's forwarded Interests then
+  time::steady_clock::TimePoint time;
+  uint64_t nForwarded = 0;
+
+  std::vector<std::pair<FaceId, float>> shares;
+};
+
+class MyMeasurementInfo : public StrategyInfo
+{
+public:
+
+  MyMeasurementInfo() : weightedFaces(new WeightedFaceSet) { ++s_nLive; }
+
+  /** \brief hands the face estimates to MeasurementRecordStore if NFD
+   *         cleared the info from a live measurements entry, i.e. the
+   *         namespace changed strategy
+   *
+   *  An info destroyed with its entry, when the entry expired, exports
+   *  nothing: no strategy is waiting for it.
+   */
+  virtual
+  ~MyMeasurementInfo();
+
+  /** \param gain of the smoothed delay
+   */
+  void
+  updateFaceDelay(const Face& face, const time::milliseconds& delay, double gain = 0.125);
+
+  /** \brief reconcile the stored faces with the current FIB nexthops
+   *
+   *  Faces that are still nexthops keep their measurements, new nexthops
+   *  start unmeasured and faces that are no longer nexthops are dropped.
+   *  Nothing is allocated when the nexthops have not changed.
+   */
+  void
+  updateStoredNextHops(const fib::NextHopList& nexthops);
+
+  /** \return whether some face has not been demoted since its last Data
+   */
+  bool
+  hasHealthyFace() const;
+
+  MeasurementRecord
+  exportRecord(const Name& prefix) const;
+
+  /** \brief start the faces of \p nexthops from the estimates in \p record
+   *  \return whether \p record has a version this strategy knows
+   */
+  bool
+  importRecord(const MeasurementRecord& record, const fib::NextHopList& nexthops);
+
+  static int constexpr
+  getTypeId() { return 9971; }
+
+public:
+
+  struct ByDelay {};
+  struct ByFaceId {};
+
+  typedef boost::multi_index_container<
+    WeightedFace,
+    boost::multi_index::indexed_by<
+      boost::multi_index::ordered_unique<
+        boost::multi_index::tag<ByDelay>,
+        boost::multi_index::identity<WeightedFace>
+        >,
+      boost::multi_index::hashed_unique<
+        boost::multi_index::tag<ByFaceId>,
+        boost::multi_index::const_mem_fun<WeightedFace, FaceId, &WeightedFace::getId>
+        >
+      >
+    > WeightedFaceSet;
+
+  typedef WeightedFaceSet::index<ByDelay>::type WeightedFaceSetByDelay;
+  typedef WeightedFaceSet::index<ByFaceId>::type WeightedFaceSetByFaceId;
+
+  unique_ptr<WeightedFaceSet> weightedFaces;
+
+  /// entry to export the estimates for, when the strategy hands them off
+  weak_ptr<measurements::Entry> exportEntry;
+
+  /// Interests forwarded for the prefix, whichever face they went to
+  uint64_t nForwarded = 0;
+
+  /// SELECTOR_MODEL: the split of the active policies
+  ModelAllocation allocation;
+
+  /// the split of a shadow using SELECTOR_MODEL, apart so that evaluating
+  /// the shadow leaves the active split alone
+  unique_ptr<ModelAllocation> shadowAllocation;
+
+  static size_t s_nLive;
+
+private:
+  NFD_LOG_INCLASS_DECLARE();
+};
 
 class WeightedLoadBalancerStrategy : public Strategy
 {
@@ -59,14 +403,479 @@ public:
   virtual void
   beforeExpirePendingInterest(shared_ptr<pit::Entry> pitEntry) DECL_OVERRIDE;
 
+  /** \brief number of PIT entry infos alive across all instances
+   *
+   *  Used by leak checks, see benchmarks/strategy-soak.cpp
+   */
+  static size_t
+  getNLivePitInfos();
+
+  /** \brief number of measurement entry infos alive across all instances
+   */
+  static size_t
+  getNLiveMeasurementInfos();
+
+  /** \brief one arm of an A/B experiment
+   *
+   *  Without the candidate-* parameters there is only the control arm.
+   */
+  struct Arm
+  {
+    std::string label;
+    SelectionPolicy policy;
+    ForwardingStats stats;
+  };
+
+  const std::vector<Arm>&
+  getArms() const
+  {
+    return m_arms;
+  }
+
+  /** \brief a policy that selects a face for every Interest next to the
+   *         active one, without forwarding by it
+   *
+   *  Its choices are compared with the active ones, and its latency is
+   *  estimated from the last RTT observed on the face it picked.
+   */
+  struct Shadow
+  {
+    SelectionPolicy policy;
+
+    /// separate, so the shadow does not change the active choices
+    std::mt19937 randomGenerator;
+
+    uint64_t nDecisions = 0;
+    uint64_t nAgreements = 0;
+
+    /// satisfied Interests for which a latency could be estimated
+    uint64_t nJoined = 0;
+
+    double selectionNs = 0;
+    double activeSelectionNs = 0;
+
+    LatencyHistogram activeLatency;
+    LatencyHistogram estimatedLatency;
+
+    /// Interests per face: (active choices, shadow choices)
+    std::map<FaceId, std::pair<uint64_t, uint64_t>> load;
+  };
+
+  /** \brief a probe or prefetch in flight
+   *
+   *  Its Interest may never reach the strategy, e.g. when the Content
+   *  Store answers it or the forwarder drops it, so the entry is swept
+   *  once the Interest could no longer be pending.
+   */
+  struct PendingSynthetic
+  {
+    /// the face the Interest is for
+    FaceId faceId;
+    time::steady_clock::TimePoint deadline;
+  };
+
+  typedef std::map<Name, PendingSynthetic> PendingSyntheticMap;
+
+  /** \brief health probes to quarantined and new faces
+   *
+   *  While a prefix has Interests, each of its faces that is new or was
+   *  demoted after a timeout gets a probe Interest named
+   *  <prefix>/<suffix>/<sequence> at most once per interval.  The probe's
+   *  RTT feeds the face's delay estimate like user Data does, and until
+   *  then user Interests avoid the face as long as a measured face is
+   *  available.
+   */
+  struct Prober
+  {
+    Name suffix;
+    time::milliseconds interval;
+    time::milliseconds lifetime;
+
+    uint64_t nextSequence = 0;
+
+    /// probes in flight
+    PendingSyntheticMap pending;
+    time::steady_clock::TimePoint nextSweep;
+
+    uint64_t nSent = 0;
+    uint64_t nAnswered = 0;
+    uint64_t nTimeouts = 0;
+
+    /// probes swept without an answer or a timeout
+    uint64_t nExpired = 0;
+  };
+
+  /** \brief prefetching of sequentially numbered segments
+   *
+   *  A flow is the name of an Interest without its last component, when
+   *  that is a segment number.  Once a flow has asked for consecutive
+   *  segments, the segments up to depth ahead of the consumer are
+   *  requested from the fastest face, so their Data waits in the Content
+   *  Store.  A segment out of order stops the flow's prefetching until it
+   *  is sequential again.  Prefetches draw from the retry budget and are
+   *  not sent under load.
+   */
+  struct Prefetcher
+  {
+    struct Flow
+    {
+      uint64_t lastSegment = 0;
+
+      /// highest segment requested by the consumer or prefetched
+      uint64_t highestSegment = 0;
+      uint64_t nSequential = 0;
+
+      /// from FinalBlockId, max while unknown
+      uint64_t finalSegment = std::numeric_limits<uint64_t>::max();
+
+      /// position in idleFlows
+      std::list<Name>::iterator idlePosition;
+    };
+
+    size_t depth;
+
+    /// prefetches in flight at most
+    size_t budget;
+
+    std::map<Name, Flow> flows;
+
+    /// names of the flows, the longest idle first
+    std::list<Name> idleFlows;
+
+    /// prefetches in flight
+    PendingSyntheticMap pending;
+    time::steady_clock::TimePoint nextSweep;
+
+    uint64_t nSent = 0;
+    uint64_t nFetched = 0;
+    uint64_t nTimeouts = 0;
+
+    /// consumer Interests that found their segment's prefetch in flight
+    uint64_t nJoined = 0;
+
+    /// flows stopped by a segment out of order
+    uint64_t nStopped = 0;
+
+    /// prefetches swept without Data or a timeout
+    uint64_t nExpired = 0;
+  };
+
+  /** \brief load of a face, derived from the face's own counters
+   *
+   *  Sampled for every face in the FaceTable once per load-interval, so
+   *  it includes traffic of other prefixes and strategies and costs
+   *  nothing per packet.
+   */
+  struct FaceLoad
+  {
+    uint64_t nOutInterests = 0;
+    uint64_t nInData = 0;
+    uint64_t nInBytes = 0;
+    uint64_t nOutBytes = 0;
+
+    /// configured link capacity in bit/s, 0 if unknown
+    double capacity = 0;
+
+    /// smoothed over a few intervals
+    double utilisation = 0;
+    double lossRate = 0;
+
+    /// multiplies the weight of the face
+    double factor = 1;
+  };
+
+  /** \brief M/M/1 latency curves of the faces, for SELECTOR_MODEL
+   *
+   *  Once per interval, a face's offered load (Interests per second this
+   *  instance sent it) and mean RTT are sampled.  Taking its base delay d
+   *  as the lowest RTT seen lately, the rest of the RTT is the sojourn
+   *  time 1 / (mu - load) of an M/M/1 queue, so a sample gives the service
+   *  rate mu = load + 1 / (RTT - d), which is smoothed over samples.
+   *  Prefixes split their Interests from these curves, see allocate().
+   */
+  struct LatencyModel
+  {
+    struct FaceModel
+    {
+      uint32_t nInterests = 0;
+      uint32_t nData = 0;
+      double rttSum = 0;
+      double minRtt = std::numeric_limits<double>::max();
+
+      /// in seconds, 0 until fitted
+      double baseDelay = 0;
+
+      /// Interests per second, 0 until fitted
+      double serviceRate = 0;
+
+      /// Interests per second in the last interval
+      double load = 0;
+    };
+
+    ~LatencyModel()
+    {
+      scheduler::cancel(fitting);
+    }
+
+    void
+    countInterest(FaceId faceId)
+    {
+      ++faces[faceId].nInterests;
+    }
+
+    void
+    countData(FaceId faceId, const time::nanoseconds& rtt)
+    {
+      FaceModel& face = faces[faceId];
+      const double seconds = rtt.count() / 1e9;
+      ++face.nData;
+      face.rttSum += seconds;
+      face.minRtt = std::min(face.minRtt, seconds);
+    }
+
+    ModelObjective objective;
+    time::milliseconds interval;
+
+    std::unordered_map<FaceId, FaceModel> faces;
+    scheduler::EventId fitting;
+
+    uint64_t nFits = 0;
+    uint64_t nAllocations = 0;
+  };
+
+  /** \brief an "inspect" control command walking the name tree
+   *
+   *  Each event loop iteration visits at most INSPECTION_SLICE name tree
+   *  entries, depth first.  Entries are held by shared_ptr, so one erased
+   *  between slices is still safe to finish; prefixes added or removed
+   *  meanwhile may or may not be listed.
+   */
+  struct Inspection
+  {
+    /// entries being visited and the index of the next child to descend into
+    std::vector<std::pair<shared_ptr<name_tree::Entry>, size_t>> stack;
+
+    std::ostringstream reply;
+    size_t nPrefixes = 0;
+    StrategyControl::ReplyCallback done;
+  };
+
+  /** \brief settings of the measurements that can change while the
+   *         strategy runs
+   */
+  struct Tuning
+  {
+    /// gain of ESTIMATOR_EWMA
+    double ewmaGain = 0.125;
+
+    /// how long a prefix's measurements outlive its last Data or timeout
+    time::seconds measurementsLifetime = time::seconds(16);
+
+    /// measured prefixes a sample updates, from the longest match up;
+    /// 0 for all of them
+    size_t propagationDepth = 0;
+  };
 
 protected:
+  /** \brief apply the settings of \p parameters that can change while the
+   *         strategy runs, see LIVE_PARAMETERS
+   *
+   *  Every value is parsed before the first one is applied, so that an
+   *  invalid value leaves the strategy as it was.
+   *
+   *  \param isDryRun only parse the values
+   *  \throw StrategyParameters::Error a value is invalid
+   */
+  void
+  configure(const StrategyParameters& parameters, bool isDryRun = false);
+
+  /** \brief check the "set KEY=VALUE..." control command, see
+   *         StrategyControl::CheckedHandler
+   *
+   *  Takes the arguments whose keys are LIVE_PARAMETERS.  Control handlers
+   *  run on the forwarding thread between packets, so a callback sees
+   *  either the old settings or all of the new ones.  Faces'
+   *  measurements, statistics and pending Interests are kept.
+   */
+  StrategyControl::Action
+  reconfigure(const std::vector<std::string>& arguments, std::vector<std::string>& accepted);
+
+  /** \brief check StrategyConfig::RELOAD_COMMAND: take the current
+   *         strategy_defaults for the LIVE_PARAMETERS
+   *  \param[out] changed the parameters that change
+   *
+   *  Other parameters keep the values the instance was created with.
+   */
+  StrategyControl::Action
+  reloadDefaults(std::vector<std::string>& changed);
 
+  /** \brief check \p parameters, see configure()
+   *  \return the action applying them
+   */
+  StrategyControl::Action
+  prepareParameters(const StrategyParameters& parameters);
+
+  /** \param isShadow whether the choice is the shadow's, which uses its
+   *         own model allocation
+   */
   shared_ptr<Face>
   selectOutgoingFace(const Face& inFace,
                      const Interest& interest,
                      shared_ptr<MyMeasurementInfo>& measurementsEntryInfo,
-                     shared_ptr<pit::Entry>& pitEntry);
+                     shared_ptr<pit::Entry>& pitEntry,
+                     const SelectionPolicy& policy,
+                     std::mt19937& randomGenerator,
+                     bool isShadow = false);
+
+  shared_ptr<Face>
+  selectByPowerOfTwoChoices(const Face& inFace,
+                            shared_ptr<MyMeasurementInfo>& measurementsEntryInfo,
+                            shared_ptr<pit::Entry>& pitEntry,
+                            DelayEstimator estimator,
+                            bool isProbeGated,
+                            std::mt19937& randomGenerator);
+
+  /** \return whether an eligible face has a measured delay, so that
+   *          faces waiting for a probe can be skipped
+   */
+  bool
+  hasMeasuredFace(const Face& inFace,
+                  const MyMeasurementInfo& measurementsEntryInfo,
+                  const shared_ptr<pit::Entry>& pitEntry) const;
+
+  /** \brief sample the counters of every face and schedule the next sample
+   */
+  void
+  sampleFaceLoads();
+
+  double
+  getLoadFactor(FaceId faceId) const
+  {
+    if (m_faceLoads.empty())
+      return 1;
+
+    auto it = m_faceLoads.find(faceId);
+    return it == m_faceLoads.end() ? 1 : it->second.factor;
+  }
+
+  /** \return estimated delay divided by the load factor, in milliseconds
+   */
+  double
+  getLoadedDelay(const WeightedFace& weightedFace, DelayEstimator estimator) const
+  {
+    return weightedFace.getDelay(estimator).count() / getLoadFactor(weightedFace.getId());
+  }
+
+  /** \brief fit the latency curve of every face from the last interval's
+   *         samples and schedule the next fit
+   */
+  void
+  fitLatencyModels();
+
+  /** \brief split the Interests of a prefix among its faces into
+   *         \p allocation to minimise the latency its faces' curves
+   *         predict, once per model interval
+   *
+   *  The prefix's rate and the load other prefixes put on each face are
+   *  taken from the last interval.  While one of its faces has no curve
+   *  yet, or the prefix's rate is not known or zero, the prefix is
+   *  weighted by delay as with SELECTOR_WEIGHTED.
+   */
+  void
+  allocate(const MyMeasurementInfo& measurementsEntryInfo, ModelAllocation& allocation);
+
+  /** \brief take in what other processes learnt about the faces since
+   *         this prefix last looked, see SharedFaceTable
+   *
+   *  A failure demotes a face; Data seen elsewhere gives a new or
+   *  quarantined face the RTT observed there.  Faces measured here keep
+   *  their own delay.
+   */
+  void
+  applySharedFaces(MyMeasurementInfo& measurementsEntryInfo);
+
+  /** \brief forget the entries of \p pending past their deadline, at
+   *         most once per second
+   *  \return how many were forgotten
+   */
+  static size_t
+  sweepPending(PendingSyntheticMap& pending, time::steady_clock::TimePoint& nextSweep);
+
+  /** \brief send due probes to the faces of \p fibEntry
+   */
+  void
+  probeFaces(const fib::Entry& fibEntry,
+             const MyMeasurementInfo& measurementsEntryInfo,
+             const Face& inFace);
+
+  /** \brief follow the flow of \p name and prefetch its next segments
+   *         if it is sequential
+   */
+  void
+  prefetchAfter(const Name& name, const shared_ptr<fib::Entry>& fibEntry);
+
+  /** \brief stop prefetching the flow of \p data past its final segment
+   */
+  void
+  noteFinalSegment(const Data& data);
+
+  /** \brief send \p interest from the synthetic face, creating the face
+   *         on first use
+   */
+  void
+  expressSynthetic(const Interest& interest);
+
+  /** \brief forward a probe or prefetch from the synthetic face to the
+   *         face it is meant for
+   */
+  void
+  forwardSynthetic(const Interest& interest, shared_ptr<pit::Entry> pitEntry);
+
+  void
+  evaluateShadow(const Face& inFace,
+                 const Interest& interest,
+                 shared_ptr<MyMeasurementInfo>& measurementsEntryInfo,
+                 shared_ptr<pit::Entry>& pitEntry,
+                 MyPitInfo& pitEntryInfo,
+                 const shared_ptr<Face>& selectedFace);
+
+  /** \return the last RTT observed on \p faceId for the prefix of
+   *          \p pitEntry, zero if it has none
+   */
+  time::milliseconds
+  getObservedDelay(const pit::Entry& pitEntry, FaceId faceId);
+
+  /** \return index of the arm for an Interest, from a hash of its name
+   */
+  size_t
+  selectArm(const Name& name) const;
+
+  /** \brief reply to the "stats" control command
+   */
+  void
+  writeStats(std::ostream& os);
+
+  /** \brief reply to the "inspect [PREFIX]" control command
+   *
+   *  Lists every face of each measured prefix of this instance under
+   *  PREFIX, or of the measured prefix PREFIX falls under, or of all of
+   *  them without PREFIX.
+   */
+  void
+  inspect(const std::vector<std::string>& arguments,
+          const StrategyControl::ReplyCallback& done);
+
+  /** \brief visit the next slice of \p inspection, then reply or
+   *         schedule the next slice
+   */
+  void
+  continueInspection(const shared_ptr<Inspection>& inspection);
+
+  /** \brief add the faces of \p entry to \p inspection if it is a measured
+   *         prefix of this instance
+   */
+  void
+  inspectEntry(Inspection& inspection, const name_tree::Entry& entry) const;
 
   shared_ptr<MyPitInfo>
   myGetOrCreateMyPitInfo(const shared_ptr<pit::Entry>& entry);
@@ -81,9 +890,73 @@ protected:
 public:
   static const Name STRATEGY_NAME;
 
+  /// parameters the "set" control command may change
+  static const std::set<std::string> LIVE_PARAMETERS;
+
+  /// name tree entries an inspection visits per event loop iteration
+  static const size_t INSPECTION_SLICE;
+
 protected:
+  /// as given to the constructor, with the changes of "set"
+  StrategyParameters m_parameters;
+  Tuning m_tuning;
+
   std::mt19937 m_randomGenerator;
   RetxSuppressionExponential m_retxSuppression;
+  RetryBudget m_retryBudget;
+  LoadShedder m_loadShedder;
+
+  /// PIT entries of this instance, see PendingInterestToken
+  shared_ptr<size_t> m_nPendingInterests;
+  const Pit& m_pit;
+  FaceTable& m_faceTable;
+  NameTree& m_nameTree;
+  StrategyChoice& m_strategyChoice;
+
+  /// set by the record=PATH parameter
+  unique_ptr<StrategyRecorder> m_recorder;
+
+  /// set by the history=MINUTES parameter
+  unique_ptr<StrategyHistory> m_history;
+
+  std::vector<Arm> m_arms;
+
+  /// fraction of Interests sent to the candidate arm
+  double m_candidateFraction;
+
+  /// set by the shadow-* parameters
+  unique_ptr<Shadow> m_shadow;
+
+  /// set by the probe-* parameters
+  unique_ptr<Prober> m_prober;
+
+  /// set by the prefetch-* parameters
+  unique_ptr<Prefetcher> m_prefetcher;
+
+  /// set when a policy uses SELECTOR_MODEL
+  unique_ptr<LatencyModel> m_model;
+
+  /// created on the first probe or prefetch
+  shared_ptr<SyntheticFace> m_syntheticFace;
+
+  /// set by the shared-table=PATH parameter
+  shared_ptr<SharedFaceTable> m_sharedFaces;
+
+  /// whether estimates are handed to and taken from MeasurementRecordStore
+  bool m_isHandoffEnabled;
+
+  /// zero unless load weighting is on
+  time::milliseconds m_loadInterval;
+
+  /// link capacities in bit/s by remote FaceUri, and for other faces
+  std::map<std::string, double> m_linkCapacities;
+  double m_defaultLinkCapacity;
+
+  std::unordered_map<FaceId, FaceLoad> m_faceLoads;
+  scheduler::EventId m_loadSampling;
+
+  /// "inspect" commands still walking, answered if the strategy goes first
+  std::list<shared_ptr<Inspection>> m_inspections;
 };
 
 } // namespace fw